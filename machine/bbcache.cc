@@ -0,0 +1,532 @@
+// bbcache.cc
+//	Routines to translate basic blocks of user code, and to run
+//	user programs a block at a time.
+//
+//	The translated form of a block is its decoded instructions,
+//	executed by the same code as the interpreter (Machine::Execute),
+//	so both engines always agree on what an instruction does.  What
+//	we save is the fetch and translation of every instruction, and
+//	the call to Interrupt::OneTick after each one.
+//
+//	On an x86 host, runs of simple arithmetic instructions are also
+//	compiled into x86 code.  Only instructions that can't trap or
+//	touch memory are compiled, and each does just what Execute does
+//	to the registers, including the delayed load left by the
+//	instruction before the run.  (OR and SRL are left out, since
+//	Execute doesn't do what the MIPS does for them.)
+//
+//	Simulated time is charged exactly as Machine::Run would charge it:
+//	one UserTick per instruction, including one that raises an
+//	exception.  A block is only run without OneTick if no interrupt
+//	can come due before it finishes, so interrupts still happen at
+//	exactly the same tick.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "bbcache.h"
+#include "mipssim.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// EndsBlock
+// 	Return TRUE if a block must end after the instruction following
+//	this one (i.e., it is a branch or jump, with a delay slot).
+//----------------------------------------------------------------------
+
+static bool
+EndsBlock(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BNE:
+      case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL:
+      case OP_J: case OP_JAL: case OP_JR: case OP_JALR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Traps
+// 	Return TRUE if this instruction always traps to the kernel, so
+//	there is no point in translating past it.
+//----------------------------------------------------------------------
+
+static bool
+Traps(Instruction *instr)
+{
+    return (instr->opCode == OP_SYSCALL) || (instr->opCode == OP_RES)
+			|| (instr->opCode == OP_UNIMP);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::BlockCache
+// 	Initialize the block cache, with every slot free.
+//----------------------------------------------------------------------
+
+BlockCache::BlockCache()
+{
+#ifdef HOST_i386
+    code = AllocExecutable(BlockCacheSize * MaxBlockCode);
+#else
+    code = NULL;
+#endif
+    table = new TranslatedBlock[BlockCacheSize];
+    for (int i = 0; i < BlockCacheSize; i++) {
+	table[i].physPC = -1;
+	table[i].length = 0;
+	table[i].hits = 0;
+	table[i].next[0] = table[i].next[1] = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// BlockCache::~BlockCache
+// 	De-allocate the block cache.
+//----------------------------------------------------------------------
+
+BlockCache::~BlockCache()
+{
+    if (code != NULL)
+	DeallocExecutable(code, BlockCacheSize * MaxBlockCode);
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::IsValid
+// 	Check that a block is a translation of the code at "physAddr",
+//	and that nothing on its page has been written since it was
+//	translated.
+//----------------------------------------------------------------------
+
+bool
+BlockCache::IsValid(TranslatedBlock *block, int physAddr)
+{
+    return (block->physPC == physAddr) && (block->length > 0) &&
+	(block->version == machine->codeVersion[physAddr / PageSize]);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Lookup
+// 	Find the translated block starting at a physical address.
+//
+//	Each slot can hold one block.  If the slot is holding some other
+//	block, we simply take it over; any links to the old block will
+//	notice, because the address no longer matches.
+//
+//	Returns NULL if the block has not been reached often enough to
+//	be worth translating.
+//
+//	"physAddr" -- the physical address of the first instruction
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BlockCache::Lookup(int physAddr)
+{
+    TranslatedBlock *block = &table[(physAddr >> 2) % BlockCacheSize];
+
+    if (block->physPC != physAddr) {		// someone else's slot
+	block->physPC = physAddr;
+	block->length = 0;
+	block->hits = 0;
+	block->next[0] = block->next[1] = NULL;
+    }
+    if (IsValid(block, physAddr))
+	return block;
+    if ((block->length == 0) && (++block->hits < HotBlockThreshold))
+	return NULL;				// still cold
+    Translate(block, physAddr);			// hot, or stale
+    return block;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Chain
+// 	Find the block that runs after "from", following the link left
+//	the last time if it still leads to the right place.  Otherwise,
+//	look the block up and remember it for next time.
+//
+//	"from" -- the block that has just finished running
+//	"physAddr" -- the physical address we ended up at
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BlockCache::Chain(TranslatedBlock *from, int physAddr)
+{
+    int which = (physAddr == from->physPC + from->length * 4) ? 0 : 1;
+    TranslatedBlock *to = from->next[which];
+
+    if ((to != NULL) && IsValid(to, physAddr))
+	return to;
+    to = Lookup(physAddr);
+    if (to != NULL)
+	from->next[which] = to;
+    return to;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Translate
+// 	Decode the instructions of a basic block, starting at "physAddr",
+//	into "block".  The block stops after the delay slot of the first
+//	branch or jump, after an instruction that always traps, at the
+//	end of the page, or when it reaches MaxBlockLength.
+//----------------------------------------------------------------------
+
+void
+BlockCache::Translate(TranslatedBlock *block, int physAddr)
+{
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    bool lastOne = FALSE;
+    int n;
+
+    block->physPC = physAddr;
+    block->version = machine->codeVersion[physAddr / PageSize];
+    block->next[0] = block->next[1] = NULL;
+    for (n = 0; (n < MaxBlockLength) && (physAddr < pageEnd); n++) {
+	block->instrs[n] = *machine->DecodeAt(physAddr);
+	block->native[n] = NULL;
+	physAddr += 4;
+	if (lastOne || Traps(&block->instrs[n])) {
+	    n++;
+	    break;
+	}
+	lastOne = EndsBlock(&block->instrs[n]);
+    }
+    block->length = n;
+#ifdef HOST_i386
+    if ((code != NULL) && !DebugIsEnabled('m'))	// the host code can't
+	Compile(block);				// trace instructions
+#endif
+    DEBUG('m', "Translated block at 0x%x, %d instructions\n",
+					block->physPC, block->length);
+}
+
+#ifdef HOST_i386
+// The generated code keeps the address of machine->registers in EDX,
+// and works in EAX and ECX.  These are the x86 register numbers.
+
+#define X86EAX		0
+#define X86ECX		1
+#define X86EDX		2
+
+// x86 opcodes taking a register and a simulated register (in memory)
+
+#define X86Load		0x8b	// mov reg, mem
+#define X86Store	0x89	// mov mem, reg
+#define X86Add		0x03
+#define X86Sub		0x2b
+#define X86And		0x23
+#define X86Or		0x0b
+#define X86Xor		0x33
+#define X86Cmp		0x3b
+
+//----------------------------------------------------------------------
+// EmitByte, EmitWord
+// 	Append a byte, or a 32-bit word, to the host code at "code", and
+//	return where the code continues.
+//----------------------------------------------------------------------
+
+static char *
+EmitByte(char *code, int byte)
+{
+    *code = (char) byte;
+    return code + 1;
+}
+
+static char *
+EmitWord(char *code, int word)
+{
+    bcopy((char *) &word, code, 4);	// the host is little endian
+    return code + 4;
+}
+
+//----------------------------------------------------------------------
+// EmitRegOp
+// 	Append an instruction whose operands are x86 register "reg" and
+//	simulated register "mipsReg", i.e., the word at EDX + 4 * mipsReg.
+//----------------------------------------------------------------------
+
+static char *
+EmitRegOp(char *code, int opcode, int reg, int mipsReg)
+{
+    code = EmitByte(code, opcode);
+    code = EmitByte(code, 0x80 | (reg << 3) | X86EDX);	// [EDX + disp32]
+    return EmitWord(code, mipsReg * 4);
+}
+
+//----------------------------------------------------------------------
+// EmitImmOp
+// 	Append an instruction combining EAX with a constant: "opcode" is
+//	the short form for EAX (e.g., 0x05 for add).
+//----------------------------------------------------------------------
+
+static char *
+EmitImmOp(char *code, int opcode, int value)
+{
+    code = EmitByte(code, opcode);
+    return EmitWord(code, value);
+}
+
+//----------------------------------------------------------------------
+// EmitSet
+// 	Append code setting EAX to 1 if the last comparison found
+//	"condition" (0x9c for less, 0x92 for below), and 0 otherwise.
+//----------------------------------------------------------------------
+
+static char *
+EmitSet(char *code, int condition)
+{
+    code = EmitByte(code, 0x0f);		// setcc al
+    code = EmitByte(code, condition);
+    code = EmitByte(code, 0xc0);
+    code = EmitByte(code, 0x0f);		// movzx eax, al
+    code = EmitByte(code, 0xb6);
+    return EmitByte(code, 0xc0);
+}
+
+//----------------------------------------------------------------------
+// Compilable
+// 	Return the register an instruction sets if we can compile it into
+//	host code, or -1 if it has to be run by Execute.
+//----------------------------------------------------------------------
+
+static int
+Compilable(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_ADDU: case OP_SUBU: case OP_AND: case OP_XOR: case OP_NOR:
+      case OP_SLL: case OP_SRA: case OP_SLLV: case OP_SRAV:
+      case OP_SLT: case OP_SLTU:
+	return instr->rd;
+      case OP_ADDIU: case OP_ANDI: case OP_ORI: case OP_XORI: case OP_LUI:
+      case OP_SLTI: case OP_SLTIU:
+	return instr->rt;
+      default:
+	return -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// EmitInstruction
+// 	Append host code that does what Execute does to the registers
+//	for "instr", apart from the delayed load and the program counters.
+//	Setting register 0 does nothing, as Execute puts it back to 0.
+//----------------------------------------------------------------------
+
+static char *
+EmitInstruction(char *code, Instruction *instr)
+{
+    int dest = Compilable(instr);
+
+    ASSERT(dest != -1);
+    if (dest == 0)
+	return code;
+    switch (instr->opCode) {
+      case OP_ADDU: case OP_SUBU: case OP_AND: case OP_XOR: case OP_NOR:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rs);
+	if (instr->opCode == OP_ADDU)
+	    code = EmitRegOp(code, X86Add, X86EAX, instr->rt);
+	else if (instr->opCode == OP_SUBU)
+	    code = EmitRegOp(code, X86Sub, X86EAX, instr->rt);
+	else if (instr->opCode == OP_AND)
+	    code = EmitRegOp(code, X86And, X86EAX, instr->rt);
+	else if (instr->opCode == OP_XOR)
+	    code = EmitRegOp(code, X86Xor, X86EAX, instr->rt);
+	else {
+	    code = EmitRegOp(code, X86Or, X86EAX, instr->rt);
+	    code = EmitByte(code, 0xf7);		// not eax
+	    code = EmitByte(code, 0xd0);
+	}
+	break;
+
+      case OP_ADDIU:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rs);
+	code = EmitImmOp(code, 0x05, instr->extra);	// add eax, imm
+	break;
+
+      case OP_ANDI: case OP_ORI: case OP_XORI:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rs);
+	code = EmitImmOp(code, (instr->opCode == OP_ANDI) ? 0x25 :
+			(instr->opCode == OP_ORI) ? 0x0d : 0x35,
+			instr->extra & 0xffff);
+	break;
+
+      case OP_LUI:
+	code = EmitImmOp(code, 0xb8, instr->extra << 16);	// mov eax, imm
+	break;
+
+      case OP_SLL: case OP_SRA:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rt);
+	code = EmitByte(code, 0xc1);			// shl/sar eax, imm
+	code = EmitByte(code, (instr->opCode == OP_SLL) ? 0xe0 : 0xf8);
+	code = EmitByte(code, instr->extra);
+	break;
+
+      case OP_SLLV: case OP_SRAV:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rt);
+	code = EmitRegOp(code, X86Load, X86ECX, instr->rs);
+	code = EmitByte(code, 0xd3);			// shl/sar eax, cl;
+	code = EmitByte(code, (instr->opCode == OP_SLLV) ? 0xe0 : 0xf8);
+	break;						// x86 also uses
+							// just 5 bits of cl
+      case OP_SLT: case OP_SLTU:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rs);
+	code = EmitRegOp(code, X86Cmp, X86EAX, instr->rt);
+	code = EmitSet(code, (instr->opCode == OP_SLT) ? 0x9c : 0x92);
+	break;
+
+      case OP_SLTI: case OP_SLTIU:
+	code = EmitRegOp(code, X86Load, X86EAX, instr->rs);
+	code = EmitImmOp(code, 0x3d, instr->extra);	// cmp eax, imm
+	code = EmitSet(code, (instr->opCode == OP_SLTI) ? 0x9c : 0x92);
+	break;
+
+      default:
+	ASSERT(FALSE);
+    }
+    return EmitRegOp(code, X86Store, X86EAX, dest);
+}
+
+//----------------------------------------------------------------------
+// EmitDelayedLoad
+// 	Append host code doing Machine::DelayedLoad(0, 0): finish the
+//	load left pending by the instruction before, and clear it.
+//----------------------------------------------------------------------
+
+static char *
+EmitDelayedLoad(char *code)
+{
+    code = EmitRegOp(code, X86Load, X86EAX, LoadReg);
+    code = EmitRegOp(code, X86Load, X86ECX, LoadValueReg);
+    code = EmitByte(code, 0x89);		// mov [edx + 4 * eax], ecx
+    code = EmitByte(code, 0x0c);
+    code = EmitByte(code, 0x82);
+    code = EmitByte(code, 0x31);		// xor eax, eax
+    code = EmitByte(code, 0xc0);
+    code = EmitRegOp(code, X86Store, X86EAX, LoadReg);
+    code = EmitRegOp(code, X86Store, X86EAX, LoadValueReg);
+    return EmitRegOp(code, X86Store, X86EAX, 0);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Compile
+// 	Compile each run of two or more instructions in a block that
+//	Compilable accepts into host code, a function of no arguments
+//	run by Machine::RunBlocks in place of the instructions.
+//
+//	A run must not include the delay slot at the end of a block:
+//	RunBlocks sets the program counters after a run as if it were
+//	straight-line code.
+//
+//	Only the first instruction in a run can have a load pending from
+//	the instruction before it; after that, the delayed load in
+//	Execute just makes sure register 0 is still 0.
+//----------------------------------------------------------------------
+
+void
+BlockCache::Compile(TranslatedBlock *block)
+{
+    char *start = code + (block - table) * MaxBlockCode;
+    char *next = start;
+    char *regs = (char *) machine->registers;
+    int i, n, last = block->length;
+
+    if ((last >= 2) && EndsBlock(&block->instrs[last - 2]))
+	last--;					// leave out the delay slot
+    for (i = 0; i < last; i += n) {
+	for (n = 0; (i + n < last) &&
+			(Compilable(&block->instrs[i + n]) != -1); n++)
+	    ;
+	if (n < 2) {				// not worth it
+	    n = 1;
+	    continue;
+	}
+	block->native[i] = next;
+	block->nativeLength[i] = n;
+	if (sizeof(regs) == 8)
+	    next = EmitByte(next, 0x48);	// a 64-bit host: mov rdx, imm64
+	next = EmitByte(next, 0xba);		// mov edx, imm
+	bcopy((char *) &regs, next, sizeof(regs));
+	next += sizeof(regs);
+	next = EmitInstruction(next, &block->instrs[i]);
+	next = EmitDelayedLoad(next);
+	for (int j = 1; j < n; j++)
+	    next = EmitInstruction(next, &block->instrs[i + j]);
+	next = EmitByte(next, 0xc3);		// ret
+	ASSERT(next - start <= MaxBlockCode);
+	DEBUG('m', "Compiled %d instructions at 0x%x\n", n,
+					block->physPC + i * 4);
+    }
+}
+#endif // HOST_i386
+
+//----------------------------------------------------------------------
+// Machine::RunBlocks
+// 	Simulate the execution of a user-level program, a basic block at
+//	a time.  Called by Run; never returns.
+//
+//	A block is only entered at the start of a straight-line sequence
+//	(not in a branch delay slot); otherwise, or if the block isn't
+//	translated yet, or an interrupt would come due part way through
+//	it, we run one instruction the ordinary way.
+//
+//	Instructions compiled into host code are run all at once, and
+//	the program counters then set as Execute would have left them.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlocks()
+{
+    TranslatedBlock *block, *prev = NULL;
+    int pc, physAddr, version, i, n;
+
+    for (;;) {
+	pc = registers[PCReg];
+	block = NULL;
+	if ((registers[NextPCReg] == pc + 4) &&
+			(Translate(pc, &physAddr, 4, FALSE) == NoException)) {
+	    if (prev != NULL)
+		block = blockCache->Chain(prev, physAddr);
+	    else
+		block = blockCache->Lookup(physAddr);
+	}
+	prev = NULL;
+	if ((block == NULL) ||
+	    (stats->totalTicks + block->length >= interrupt->NextDueTime())) {
+	    OneInstruction();
+	    interrupt->OneTick();
+	    continue;
+	}
+
+	version = codeVersion[physAddr / PageSize];
+	for (i = 0; i < block->length; i++) {
+	    if (block->native[i] != NULL) {
+		n = block->nativeLength[i];
+		((void (*)()) block->native[i])();
+		registers[PrevPCReg] = registers[PCReg] + (n - 1) * 4;
+		registers[PCReg] += n * 4;
+		registers[NextPCReg] = registers[PCReg] + 4;
+		stats->totalTicks += n * UserTick;
+		stats->userTicks += n * UserTick;
+		i += n - 1;
+		continue;
+	    }
+	    if (!Execute(&block->instrs[i]))
+		break;
+	    stats->totalTicks += UserTick;	// the same as OneTick, but
+	    stats->userTicks += UserTick;	// we know nothing is due
+	    if (codeVersion[physAddr / PageSize] != version) {
+		i = -1;				// the block wrote to its own
+		break;				// page; what's left is stale
+	    }
+	}
+	if (i == block->length)
+	    prev = block;
+	else if (i >= 0)			// the exception still takes
+	    interrupt->OneTick();		// a tick, and the kernel may
+						// have changed anything
+    }
+}
@@ -0,0 +1,98 @@
+// bbcache.h
+//	Data structures for running user programs a basic block at a
+//	time, rather than an instruction at a time.
+//
+//	A basic block is a run of instructions on one physical page that
+//	ends just after a branch or jump (and its delay slot), at a
+//	syscall, or at the end of the page.  Once execution has reached
+//	the start of a block often enough, the block is "translated": its
+//	instructions are decoded once and stored together, along with
+//	the number of ticks running them will take.  From then on, the
+//	whole block can be run without fetching each instruction, and,
+//	if no interrupt can become due before it finishes, without calling
+//	Interrupt::OneTick after each one.
+//
+//	Blocks are found by the physical address of their first
+//	instruction.  Each block also remembers the blocks that followed
+//	it, so that the common case of going from one block to the next
+//	doesn't need a table lookup.
+//
+//	On an x86 host (HOST_i386), each run of two or more simple
+//	arithmetic instructions in a block is also compiled into host
+//	code, which works directly on the simulated registers.  Loads,
+//	stores, branches, and anything else that can trap still go
+//	through the decoded instructions, as does everything if the host
+//	won't give us memory to run code from.
+//
+//	Anything unusual -- an exception, an interrupt coming due, code
+//	that has not been executed often enough yet, or a write to a page
+//	that code was translated from -- drops back to OneInstruction.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BBCACHE_H
+#define BBCACHE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxBlockLength		32	// longest block we translate
+#define BlockCacheSize		1024	// number of translated blocks kept
+#define HotBlockThreshold	8	// times a block must be reached
+					// before we translate it
+#define MaxBlockCode		2048	// bytes of host code per block
+
+// The following class defines one slot of the block cache.  A slot
+// starts out describing a block that is only being counted; it is
+// translated once it is hot.
+
+class TranslatedBlock {
+  public:
+    int physPC;			// physical address of the first
+				// instruction, -1 if the slot is free
+    int version;		// the page's machine->codeVersion when
+				// the block was translated
+    int hits;			// times reached, before being translated
+    int length;			// number of instructions, which is also
+				// the number of ticks to run them;
+				// 0 if not translated yet
+    Instruction instrs[MaxBlockLength];
+    char *native[MaxBlockLength];	// host code running the instructions
+				// from here on, or NULL
+    int nativeLength[MaxBlockLength];	// how many instructions it runs
+    TranslatedBlock *next[2];	// the blocks that followed this one:
+				// falling through, and branching away
+};
+
+// The following class defines the cache of translated blocks.
+
+class BlockCache {
+  public:
+    BlockCache();		// initialize an empty cache
+    ~BlockCache();		// de-allocate the cache
+
+    TranslatedBlock *Lookup(int physAddr);
+				// Return the translated block starting at
+				// "physAddr", or NULL if it isn't hot yet
+    TranslatedBlock *Chain(TranslatedBlock *from, int physAddr);
+				// Same as Lookup, for the block run right
+				// after "from"; remembers the link
+
+  private:
+    void Translate(TranslatedBlock *block, int physAddr);
+				// Fill in the instructions of a block
+    bool IsValid(TranslatedBlock *block, int physAddr);
+				// Is "block" an up to date translation
+				// of the code at "physAddr"?
+    void Compile(TranslatedBlock *block);
+				// Compile what we can of a block into
+				// host code
+
+    TranslatedBlock *table;	// the blocks, hashed by physical address
+    char *code;			// MaxBlockCode bytes of host code for
+				// each block, or NULL if we can't run any
+};
+
+#endif // BBCACHE_H
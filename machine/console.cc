@@ -81,6 +81,10 @@ Console::~Console()
 //	character has been grabbed out of the buffer by the Nachos kernel).
 //	Invoke the "read" interrupt handler, once the character has been 
 //	put into the buffer. 
+//
+//	When the UNIX file runs out, the handler is called once more with
+//	nothing in the buffer, so that GetChar returns EOF, and we stop
+//	polling.
 //----------------------------------------------------------------------
 
 void
@@ -88,19 +92,21 @@ Console::CheckCharAvail()
 {
     char c;
 
+    // do nothing if character is already buffered, or none to be read
+    if ((incoming == EOF) && PollFile(readFileNo)) {
+	// otherwise, read character and tell user about it
+	if (ReadPartial(readFileNo, &c, sizeof(char)) != sizeof(char)) {
+	    (*readHandler)(handlerArg);		// end of input
+	    return;
+	}
+	incoming = c ;
+	stats->numConsoleCharsRead++;
+	(*readHandler)(handlerArg);	
+    }
+
     // schedule the next time to poll for a packet
     interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
 			ConsoleReadInt);
-
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
-    incoming = c ;
-    stats->numConsoleCharsRead++;
-    (*readHandler)(handlerArg);	
 }
 
 //----------------------------------------------------------------------
@@ -114,7 +120,8 @@ void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
+    stats->numConsoleWriteInts++;
     (*writeHandler)(handlerArg);
 }
 
@@ -145,6 +152,26 @@ Console::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
+    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+					ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// Console::PutChars()
+// 	Write "count" characters to the simulated display, in one burst:
+//	the display takes them all in the time it takes to put one, and
+//	only one interrupt is scheduled for the lot.
+//----------------------------------------------------------------------
+
+void
+Console::PutChars(char *buffer, int count)
+{
+    ASSERT(putBusy == FALSE);
+    ASSERT((count > 0) && (count <= ConsoleBurst));
+    WriteFile(writeFileNo, buffer, count);
+    putBusy = TRUE;
+    putCount = count;
     interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
 					ConsoleWriteInt);
 }
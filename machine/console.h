@@ -26,6 +26,9 @@
 #include "copyright.h"
 #include "utility.h"
 
+#define ConsoleBurst	64	// most characters the display takes in
+				// one PutChars
+
 // The following class defines a hardware console device.
 // Input and output to the device is simulated by reading 
 // and writing to UNIX files ("readFile" and "writeFile").
@@ -46,11 +49,16 @@ class Console {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutChars(char *buffer, int count);
+				// Write up to ConsoleBurst characters at
+				// once; "writeHandler" is called once,
+				// when all of them have gone out
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
     				// "readHandler" is called whenever there is 
-				// a char to be gotten
+				// a char to be gotten, and once at the end
+				// of the input, when there is not
 
 // internal emulation routines -- DO NOT call these. 
     void WriteDone();	 	// internal routines to signal I/O completion
@@ -67,6 +75,7 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// how many characters it is putting
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
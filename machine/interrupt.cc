@@ -30,24 +30,147 @@ static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
 			"console read", "network send", "network recv"};
 
+#define InitialQueueSize	64	// slots in a new PendingQueue
+
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+// 	Initialize an empty queue of pending interrupts.
+//----------------------------------------------------------------------
+
+PendingQueue::PendingQueue()
+{
+    size = InitialQueueSize;
+    heap = new PendingInterrupt[size];
+    numPending = 0;
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+// 	De-allocate the queue, and any interrupts still on it.
 //----------------------------------------------------------------------
-// PendingInterrupt::PendingInterrupt
-// 	Initialize a hardware device interrupt that is to be scheduled 
-//	to occur in the near future.
+
+PendingQueue::~PendingQueue()
+{
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Before
+// 	Return TRUE if interrupt "a" should occur before "b": it is due
+//	earlier, or at the same time but was scheduled first.  ("order"
+//	may wrap around, so we compare the difference.)
+//----------------------------------------------------------------------
+
+bool
+PendingQueue::Before(PendingInterrupt *a, PendingInterrupt *b)
+{
+    if (a->when != b->when)
+	return (a->when < b->when);
+    return ((int) (a->order - b->order) < 0);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+// 	Schedule an interrupt, by putting it on the queue after any
+//	others due at the same time.
 //
-//	"func" is the procedure to call when the interrupt occurs
-//	"param" is the argument to pass to the procedure
-//	"time" is when (in simulated time) the interrupt is to occur
-//	"kind" is the hardware device that generated the interrupt
+//	"handler" is the procedure to call when the interrupt occurs
+//	"arg" is the argument to pass to the procedure
+//	"when" is when (in simulated time) the interrupt is to occur
+//	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 
-PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, 
-				IntType kind)
+void
+PendingQueue::Insert(VoidFunctionPtr handler, int arg, int when, IntType type)
 {
-    handler = func;
-    arg = param;
-    when = time;
-    type = kind;
+    PendingInterrupt item;
+
+    item.handler = handler;
+    item.arg = arg;
+    item.when = when;
+    item.type = type;
+    item.order = nextOrder++;
+    Add(&item);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Add
+// 	Put a copy of "item" at the bottom of the heap, and move it up
+//	past any parents that should occur after it.  The heap is only
+//	re-allocated when it is full.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Add(PendingInterrupt *item)
+{
+    int i, parent;
+
+    if (numPending == size) {		// full; double the heap
+	PendingInterrupt *bigger = new PendingInterrupt[size * 2];
+
+	for (i = 0; i < numPending; i++)
+	    bigger[i] = heap[i];
+	delete [] heap;
+	heap = bigger;
+	size *= 2;
+    }
+    for (i = numPending++; i > 0; i = parent) {
+	parent = (i - 1) / 2;
+	if (!Before(item, &heap[parent]))
+	    break;
+	heap[i] = heap[parent];
+    }
+    heap[i] = *item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::RemoveFirst
+// 	Take the earliest interrupt off the queue, copying it into
+//	"toOccur".  The last interrupt on the heap fills the hole, and
+//	moves down past any children that should occur before it.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::RemoveFirst(PendingInterrupt *toOccur)
+{
+    PendingInterrupt *last;
+    int i, child;
+
+    ASSERT(!IsEmpty());
+    *toOccur = heap[0];
+    last = &heap[--numPending];
+    for (i = 0; (child = 2 * i + 1) < numPending; i = child) {
+	if ((child + 1 < numPending) && Before(&heap[child + 1], &heap[child]))
+	    child++;
+	if (!Before(&heap[child], last))
+	    break;
+	heap[i] = heap[child];
+    }
+    heap[i] = *last;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Mapcar
+// 	Apply a function to each interrupt on the queue, earliest first,
+//	by emptying a copy of the queue.  Only used for debugging.
+//
+//	"func" is the procedure to apply; it is passed a PendingInterrupt *
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Mapcar(VoidFunctionPtr func)
+{
+    PendingQueue *sorted = new PendingQueue();
+    PendingInterrupt next;
+
+    for (int i = 0; i < numPending; i++)
+	sorted->Add(&heap[i]);
+    while (!sorted->IsEmpty()) {
+	sorted->RemoveFirst(&next);
+	(*func)((int) &next);
+    }
+    delete sorted;
 }
 
 //----------------------------------------------------------------------
@@ -60,7 +183,8 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new PendingQueue();
+    nextDue = NeverDue;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -73,8 +197,6 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete pending->Remove();
     delete pending;
 }
 
@@ -88,7 +210,8 @@ Interrupt::~Interrupt()
 // 	Change interrupts to be enabled or disabled, without advancing 
 //	the simulated time (normally, enabling interrupts advances the time).
 //
-//	Used internally.
+//	Used internally, and by the scheduler when it switches between
+//	simulated CPUs.
 //
 //	"old" -- the old interrupt status
 //	"now" -- the new interrupt status
@@ -241,7 +364,13 @@ void
 Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
+#ifdef USE_TLB
+    stats->numTLBHits = machine->TLBHits();
+#endif
     stats->Print();
+#ifdef USER_PROGRAM
+    PrintSyscallCounts();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -250,7 +379,8 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it on the queue of pending interrupts,
+//	which keeps them in order.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -265,13 +395,14 @@ void
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
 
     DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(handler, arg, when, type);
+    if (when < nextDue)
+	nextDue = when;
 }
 
 //----------------------------------------------------------------------
@@ -291,35 +422,40 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
+    PendingInterrupt toOccur;
     int when;
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
-
-    if (toOccur == NULL)		// no pending interrupts
+    if (pending->IsEmpty())		// no pending interrupts
 	return FALSE;			
 
+    // Look before removing: taking the first interrupt off and putting
+    // it back would move it behind others due at the same time, so their
+    // order would depend on how often we happened to check.
+    if (!advanceClock && pending->First()->when > stats->totalTicks)
+	return FALSE;			// not time yet
+    pending->RemoveFirst(&toOccur);
+    when = toOccur.when;
+    nextDue = pending->IsEmpty() ? NeverDue : pending->First()->when;
+
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
-	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
-    if ((status == IdleMode) && (toOccur->type == TimerInt) 
+    if ((status == IdleMode) && (toOccur.type == TimerInt) 
 				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+	 pending->Insert(toOccur.handler, toOccur.arg, when, toOccur.type);
+	 nextDue = when;
 	 return FALSE;
     }
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
-			intTypeNames[toOccur->type], toOccur->when);
+			intTypeNames[toOccur.type], toOccur.when);
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -328,10 +464,9 @@ Interrupt::CheckIfDue(bool advanceClock)
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
-    (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
+    (*(toOccur.handler))(toOccur.arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
     return TRUE;
 }
 
@@ -41,6 +41,8 @@
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
 
+#define NeverDue	0x7fffffff	// due time when nothing is pending
+
 // Nachos can be running kernel code (SystemMode), user code (UserMode),
 // or there can be no runnable thread, because the ready list 
 // is empty (IdleMode).
@@ -54,19 +56,57 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
-// left public to make it simpler to manipulate.
+// left public to make it simpler to manipulate.  They are filled
+// in by PendingQueue::Insert.
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(VoidFunctionPtr func, int param, int time, IntType kind);
-				// initialize an interrupt that will
-				// occur in the future
-
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned int order;		// when it was scheduled, relative to
+				// others due at the same time
+};
+
+// The following class defines the queue of interrupts scheduled to
+// occur in the future, earliest first.  Interrupts due at the same
+// time come out in the order they went in.
+//
+// The queue is a binary heap, kept in an array of PendingInterrupts
+// that only grows (doubling) when it is full, so scheduling and firing
+// an interrupt take O(log n) time and don't allocate any memory.
+
+class PendingQueue {
+  public:
+    PendingQueue();		// initialize an empty queue
+    ~PendingQueue();		// de-allocate the queue
+
+    bool IsEmpty() { return (numPending == 0); }
+    PendingInterrupt *First() { return &heap[0]; }
+				// The earliest interrupt; the queue
+				// must not be empty
+    void Insert(VoidFunctionPtr handler, int arg, int when, IntType type);
+				// Add an interrupt to the queue
+    void RemoveFirst(PendingInterrupt *toOccur);
+				// Copy the earliest interrupt into
+				// "toOccur", and take it off the queue
+    void Mapcar(VoidFunctionPtr func);
+				// Apply "func" to each interrupt on the
+				// queue, earliest first
+
+  private:
+    void Add(PendingInterrupt *item);
+				// Put a copy of "item" on the heap
+    bool Before(PendingInterrupt *a, PendingInterrupt *b);
+				// Should "a" occur before "b"?
+
+    PendingInterrupt *heap;	// heap[i] occurs no later than its
+				// children, heap[2i+1] and heap[2i+2]
+    int numPending;		// number of interrupts on the heap
+    int size;			// number of slots in "heap"
+    unsigned int nextOrder;	// "order" for the next interrupt
 };
 
 // The following class defines the data structures for the simulation
@@ -111,11 +151,22 @@ class Interrupt {
     					// by the hardware device simulators.
     
     void OneTick();       		// Advance simulated time
+    void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
+	IntStatus now);  		// simulated time (used by the
+					// scheduler to switch CPUs)
+
+    int NextDueTime() { return nextDue; }
+					// When the next pending interrupt
+					// is due; the simulator may run
+					// user code without calling OneTick
+					// until just before then
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingQueue *pending;	// the interrupts scheduled to occur
+				// in the future
+    int nextDue;		// when the first of them is due, or
+				// NeverDue if there are none
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -125,9 +176,6 @@ class Interrupt {
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
-
-    void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
-	IntStatus now);  		// simulated time
 };
 
 #endif // INTERRRUPT_H
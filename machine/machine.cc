@@ -9,6 +9,8 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "bbcache.h"
+#include "quantum.h"
 #include "system.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -50,9 +52,15 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"how" -- which execution engine Run() should use
+//	"cpus" -- how many CPUs to simulate
+//	"quantum" -- if non-zero, run the CPUs this many ticks at a time
+//		(see quantum.h)
+//	"hostThreads" -- if TRUE, run those quanta on host threads
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, ExecEngine how, int cpus, int quantum,
+		 bool hostThreads, int tlbEntries)
 {
     int i;
 
@@ -61,18 +69,110 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
+    for (i = 0; i < NumPhysPages; i++) {
+	decodeCache[i] = NULL;
+	codeVersion[i] = 0;
+    }
+    engine = how;
+    if (engine == BlockEngine)
+	blockCache = new BlockCache();
+    else
+	blockCache = NULL;
+    ASSERT((cpus > 0) && (cpus <= MaxCPUs));
+    numCPUs = cpus;
+    for (i = 0; i < MaxCPUs; i++) {
+	cpuTLBHits[i] = 0;
+	cpuPageTable[i] = NULL;
+	cpuPageTableSize[i] = 0;
+    }
+    currentCPU = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
+    ASSERT(tlbEntries > 0);
+    tlbSize = tlbEntries;
+    cpuTLB = new TranslationEntry *[numCPUs];
+    cpuTLBLastUse = new unsigned int *[numCPUs];
+    for (i = 0; i < numCPUs; i++) {
+	cpuTLB[i] = new TranslationEntry[tlbSize];
+	cpuTLBLastUse[i] = new unsigned int[tlbSize];
+	for (int j = 0; j < tlbSize; j++) {
+	    cpuTLB[i][j].valid = FALSE;
+	    cpuTLBLastUse[i][j] = 0;
+	}
+    }
+    tlb = cpuTLB[0];
+    tlbLastUse = cpuTLBLastUse[0];
     pageTable = NULL;
 #else	// use linear page table
+    tlbSize = 0;
+    cpuTLB = NULL;
+    cpuTLBLastUse = NULL;
     tlb = NULL;
+    tlbLastUse = NULL;
     pageTable = NULL;
 #endif
+    pageTableSize = 0;
+    tlbHits = &cpuTLBHits[0];
 
+    FlushSoftTLB();
     singleStep = debug;
     CheckEndian();
+
+    parent = NULL;
+    for (i = 0; i < NumPhysPages; i++)
+	wroteFrame[i] = FALSE;
+    if (quantum > 0)
+	quanta = new QuantumRunner(this, numCPUs, quantum, hostThreads);
+    else
+	quanta = NULL;
+}
+
+//----------------------------------------------------------------------
+// Machine::Machine
+// 	Initialize a machine that runs quanta of user code for another
+//	one, "main", on behalf of one of its CPUs.  It shares main's
+//	physical memory, but has registers and caches of its own; its
+//	page table or TLB is whatever the CPU's thread is using.
+//
+//	Exceptions are not raised, but just stop the quantum; see
+//	RaiseException and RunQuantum.
+//
+//	"main" -- the machine the kernel uses
+//----------------------------------------------------------------------
+
+Machine::Machine(Machine *main)
+{
+    int i;
+
+    for (i = 0; i < NumTotalRegs; i++)
+        registers[i] = 0;
+    mainMemory = main->mainMemory;
+    for (i = 0; i < NumPhysPages; i++) {
+	decodeCache[i] = NULL;
+	codeVersion[i] = main->codeVersion[i];
+	wroteFrame[i] = FALSE;
+    }
+    engine = InterpretEngine;
+    blockCache = NULL;
+    numCPUs = 1;
+    for (i = 0; i < MaxCPUs; i++) {
+	cpuTLBHits[i] = 0;
+	cpuPageTable[i] = NULL;
+	cpuPageTableSize[i] = 0;
+    }
+    currentCPU = 0;
+    cpuTLB = NULL;
+    cpuTLBLastUse = NULL;
+    tlb = NULL;
+    tlbSize = main->tlbSize;
+    tlbLastUse = NULL;
+    tlbHits = NULL;
+    pageTable = NULL;
+    pageTableSize = 0;
+
+    FlushSoftTLB();
+    singleStep = FALSE;
+    quanta = NULL;
+    parent = main;
 }
 
 //----------------------------------------------------------------------
@@ -82,9 +182,23 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
-    if (tlb != NULL)
-        delete [] tlb;
+    if (quanta != NULL)
+	delete quanta;
+    if (parent == NULL)			// otherwise, it's the parent's
+	delete [] mainMemory;
+    for (int i = 0; i < NumPhysPages; i++)
+	if (decodeCache[i] != NULL)
+	    delete [] decodeCache[i];
+    if (blockCache != NULL)
+	delete blockCache;
+    if (cpuTLB != NULL) {
+	for (int i = 0; i < numCPUs; i++) {
+	    delete [] cpuTLB[i];
+	    delete [] cpuTLBLastUse[i];
+	}
+	delete [] cpuTLB;
+	delete [] cpuTLBLastUse;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -100,6 +214,9 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    if (parent != NULL)			// just running a quantum, which
+	return;				// stops here; see RunQuantum
+
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
     
 //  ASSERT(interrupt->getStatus() == UserMode);
@@ -212,3 +329,158 @@ void Machine::WriteRegister(int num, int value)
 	registers[num] = value;
     }
 
+//----------------------------------------------------------------------
+// Machine::InvalidateCodePage
+//   	Throw away the decoded instructions for a physical page, because
+//	its contents are about to change behind the simulator's back
+//	(e.g., the kernel is loading a new program into it).
+//
+//	"frame" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateCodePage(int frame)
+{
+    ASSERT((frame >= 0) && (frame < NumPhysPages));
+    codeVersion[frame]++;
+    if (decodeCache[frame] != NULL)	// keep the table, in case an
+					// instruction from it is executing
+	for (int i = 0; i < InstrsPerPage; i++)
+	    decodeCache[frame][i].opCode = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::SelectCPU
+//   	Switch the hardware over to another simulated CPU.  Each CPU has
+//	its own TLB (or page table register), and counts its own hits;
+//	translations remembered from the last CPU's are no longer any
+//	good.  What each CPU had loaded is kept, so that the kernel need
+//	not reload it unless the CPU's thread changes address space.
+//
+//	"which" -- the CPU about to run
+//----------------------------------------------------------------------
+
+void
+Machine::SelectCPU(int which)
+{
+    ASSERT((which >= 0) && (which < numCPUs));
+    cpuPageTable[currentCPU] = pageTable;
+    cpuPageTableSize[currentCPU] = pageTableSize;
+    pageTable = cpuPageTable[which];
+    pageTableSize = cpuPageTableSize[which];
+    currentCPU = which;
+    if (cpuTLB != NULL) {
+	tlb = cpuTLB[which];
+	tlbLastUse = cpuTLBLastUse[which];
+    }
+    tlbHits = &cpuTLBHits[which];
+    FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+//   	Forget all the translations ReadMem and WriteMem have remembered.
+//
+//	They set the use and dirty bits only when they call Translate,
+//	so the kernel must call this whenever it changes which page
+//	table or TLB entries are in use, or their contents -- including
+//	clearing use or dirty bits, which would otherwise stay clear.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLB()
+{
+    for (int i = 0; i < SoftTLBSize; i++)
+	softTLB[i].virtualPage = -1;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftPage
+//   	Forget the translation ReadMem and WriteMem have remembered for
+//	virtual page "vpn", if they have one.  The kernel calls this
+//	instead of FlushSoftTLB when it replaces just one TLB entry, so
+//	the translations of the other pages are kept.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftPage(int vpn)
+{
+    SoftTranslation *soft = &softTLB[(unsigned) vpn % SoftTLBSize];
+
+    if (soft->virtualPage == vpn)
+	soft->virtualPage = -1;
+}
+
+//----------------------------------------------------------------------
+// Machine::ForgetFrame
+//   	Drop every translation to physical page "frame": from the TLB of
+//	every CPU, and from the translations remembered by ReadMem and
+//	WriteMem here and on any CPU running quanta.  Called by the kernel
+//	before it takes a frame away from the page mapped to it, which
+//	need not belong to the program running right now.
+//
+//	Returns TRUE if a TLB entry dropped had its dirty bit set, so
+//	that the kernel does not lose track of the write.
+//----------------------------------------------------------------------
+
+bool
+Machine::ForgetFrame(int frame)
+{
+    bool dirty = FALSE;
+
+    if (cpuTLB != NULL)
+	for (int i = 0; i < numCPUs; i++)
+	    for (int j = 0; j < tlbSize; j++)
+		if (cpuTLB[i][j].valid && (cpuTLB[i][j].physicalPage == frame)) {
+		    dirty = dirty || cpuTLB[i][j].dirty;
+		    cpuTLB[i][j].valid = FALSE;
+		}
+    FlushSoftTLB();
+    if (quanta != NULL)
+	quanta->FlushSoftTLBs();
+    return dirty;
+}
+
+//----------------------------------------------------------------------
+// Machine::ClearFrameUse
+//   	Clear the use bit of every TLB entry, on every CPU, that
+//	translates to physical page "frame".  Translate sets the use bit
+//	in the TLB, not in the page table, so the kernel calls this to
+//	find out whether a page has been used while it was in a TLB.
+//
+//	Returns TRUE if any of the use bits was set.  The caller must
+//	call FlushSoftTLB, so that the page's next use is noticed.
+//----------------------------------------------------------------------
+
+bool
+Machine::ClearFrameUse(int frame)
+{
+    bool used = FALSE;
+
+    if (cpuTLB != NULL)
+	for (int i = 0; i < numCPUs; i++)
+	    for (int j = 0; j < tlbSize; j++)
+		if (cpuTLB[i][j].valid && (cpuTLB[i][j].physicalPage == frame)) {
+		    used = used || cpuTLB[i][j].use;
+		    cpuTLB[i][j].use = FALSE;
+		}
+    return used;
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBHits
+//   	Return how many translations have been found in a TLB, on all
+//	the CPUs together.  (References ReadMem and WriteMem satisfy
+//	from the translations they remember, or instruction fetches
+//	from decoded code, never get as far as the TLB.)
+//----------------------------------------------------------------------
+
+int
+Machine::TLBHits()
+{
+    int hits = 0;
+
+    for (int i = 0; i < numCPUs; i++)
+	hits += cpuTLBHits[i];
+    return hits;
+}
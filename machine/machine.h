@@ -34,7 +34,11 @@
 
 #define NumPhysPages   128 
 #define MemorySize 	(NumPhysPages * PageSize)
-#define TLBSize		4		// if there is a TLB, make it small
+#define DefaultTLBSize	4		// if there is a TLB, make it small
+#define MaxCPUs		16		// most simulated CPUs we allow
+#define InstrsPerPage	(PageSize / 4)	// instruction words per page
+#define SoftTLBSize	16		// translations remembered by
+					// ReadMem and WriteMem
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -71,6 +75,23 @@ enum ExceptionType { NoException,           // Everything ok!
 
 #define NumTotalRegs 	40
 
+// The simulator can run user code in more than one way.  All of them
+// give the same results, and charge the same simulated time.
+
+enum ExecEngine { InterpretEngine,	// fetch, decode and execute one
+					// instruction at a time
+		  BlockEngine,		// run basic blocks translated by
+					// the block cache (bbcache.cc)
+		  ThreadedEngine,	// jump straight from one instruction's
+					// handler to the next one's
+					// (threadedcode.cc)
+		  BatchEngine		// interpret, but only call OneTick
+					// when an interrupt is due
+};
+
+class BlockCache;
+class QuantumRunner;
+
 // The following class defines an instruction, represented in both
 // 	undecoded binary form
 //      decoded to identify
@@ -89,6 +110,24 @@ class Instruction {
     char rs, rt, rd; // Three registers from instruction.
     int extra;       // Immediate or target or shamt field or offset.
                      // Immediates are sign-extended.
+    void *handler;   // Where the threaded engine's code for this
+		     // instruction is; NULL until it first runs it.
+};
+
+// The following class defines a translation remembered by ReadMem and
+// WriteMem, so that they don't have to call Translate on every access.
+// This is part of the simulator, not the simulated machine: it is
+// invisible to the user program, as long as the kernel calls
+// Machine::FlushSoftTLB whenever it changes the page table or TLB.
+
+class SoftTranslation {
+  public:
+    int virtualPage;		// -1 if nothing is remembered
+    int physicalPage;
+    bool writable;		// TRUE if a write can skip Translate too:
+				// the page is writable and already dirty
+    int tlbEntry;		// the TLB entry it came from, which is
+				// hit again each time it is used; or -1
 };
 
 // The following class defines the simulated host workstation hardware, as 
@@ -106,8 +145,13 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, ExecEngine how, int cpus, int quantum,
+	    bool hostThreads, int tlbEntries);
+				// Initialize the simulation of the hardware
 				// for running user programs
+    Machine(Machine *main);	// Initialize a CPU for running a quantum
+				// of user code for "main", sharing its
+				// memory (see quantum.cc)
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -118,11 +162,60 @@ class Machine {
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void InvalidateCodePage(int frame);
+				// Forget any decoded instructions cached
+				// for physical page "frame".  Must be called
+				// whenever the kernel changes the contents
+				// of a page without going through WriteMem.
+    void FlushSoftTLB();	// Forget the translations remembered by
+				// ReadMem and WriteMem.  Must be called
+				// whenever the kernel changes the page
+				// table or TLB in use, or an entry of it
+				// (including clearing a use or dirty bit).
+    void FlushSoftPage(int vpn);
+				// Forget the translation remembered for
+				// virtual page "vpn", if any; enough when
+				// the kernel drops its one TLB entry.
+    bool ForgetFrame(int frame);
+				// Drop every translation, on any CPU, to
+				// physical page "frame", before the kernel
+				// maps it to another page.  Returns TRUE
+				// if a TLB entry dropped was dirty.
+    bool ClearFrameUse(int frame);
+				// Clear the use bits of the TLB entries,
+				// on any CPU, for physical page "frame";
+				// TRUE if any was set
+    int TLBHits();		// Number of translations found in the TLB,
+				// on every CPU
+
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
+    void OneInstruction(); 	// Run one instruction of a user program.
+    bool Execute(Instruction *instr);
+				// Execute an instruction that has already
+				// been fetched.  Returns FALSE if it
+				// raised an exception.
+    void RunBlocks();		// Run() using the basic block cache
+    void RunThreaded();		// Run() using threaded-code dispatch
+    void RunBatched();		// Run() charging ticks in batches
+    void RunQuanta();		// Run() a quantum at a time on every CPU
+    int RunQuantum(int limit, bool *trapped);
+				// Run up to "limit" instructions, stopping
+				// before one that would trap (CPUs made
+				// by Machine(Machine *) only)
+    void SyncCode();		// Forget code the main machine has
+				// invalidated since the last quantum
+    void PublishWrites();	// Tell the main machine which pages the
+				// last quantum wrote to
+    Instruction *FetchInstruction(int virtAddr);
+				// Return the decoded instruction at 
+				// "virtAddr", decoding it only the first
+				// time it is fetched.  Returns NULL if
+				// the fetch raised an exception.
+    Instruction *DecodeAt(int physAddr);
+				// Return the (cached) decoded instruction
+				// at physical address "physAddr"
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -143,6 +236,12 @@ class Machine {
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    void SelectCPU(int which);	// Make "which" the CPU whose TLB (or
+				// page table) is used;
+				// called by the scheduler when it switches
+				// CPUs.  (The registers belong to the
+				// thread, which saves them on a switch.)
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -160,11 +259,11 @@ class Machine {
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
 // can be controlled by one of:
-//	a traditional linear page table
+//	a two-level page table (see translate.h)
 //  	a software-loaded translation lookaside buffer (tlb) -- a cache of 
 //	  mappings of virtual page #'s to physical page #'s
 //
-// If "tlb" is NULL, the linear page table is used
+// If "tlb" is NULL, the page table is used
 // If "tlb" is non-NULL, the Nachos kernel is responsible for managing
 //	the contents of the TLB.  But the kernel can use any data structure
 //	it wants (eg, segmented paging) for handling TLB cache misses.
@@ -177,21 +276,72 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// entries in each CPU's TLB
+    unsigned int *tlbLastUse;		// for each entry of "tlb", the value
+					// of "*tlbHits" when it was last
+					// used (e.g., for LRU replacement)
+    unsigned int *tlbHits;		// translations found in the current
+					// CPU's TLB so far
 
-    TranslationEntry *pageTable;
-    unsigned int pageTableSize;
+    TranslationEntry **pageTable;	// the page table's directory
+    unsigned int pageTableSize;		// pages it covers
+
+    int numCPUs;		// number of simulated CPUs
+
+    int codeVersion[NumPhysPages];
+				// bumped whenever cached code on a page
+				// is invalidated, so that blocks translated
+				// from the page can tell they are stale
 
   private:
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+
+    Instruction *decodeCache[NumPhysPages];
+				// decoded instructions, per physical page;
+				// NULL until code is fetched from the page.
+				// An entry with opCode 0 has not been
+				// decoded yet (Decode never yields 0).
+
+    TranslationEntry **cpuTLB;	// each CPU's TLB, if there is a TLB;
+				// "tlb" points to the current CPU's
+    unsigned int **cpuTLBLastUse; // "tlbLastUse" for each CPU
+    unsigned int cpuTLBHits[MaxCPUs];
+				// "tlbHits" for each CPU
+    TranslationEntry **cpuPageTable[MaxCPUs];
+				// "pageTable" for each CPU, but the
+				// current one
+    unsigned int cpuPageTableSize[MaxCPUs];
+				// "pageTableSize" for each CPU
+    int currentCPU;		// the CPU whose TLB or page table is
+				// in use
+
+    SoftTranslation softTLB[SoftTLBSize];
+				// recent translations by ReadMem and
+				// WriteMem, direct-mapped by virtual page
+    void RememberTranslation(int virtAddr, int physAddr, bool writing);
+				// Put a translation in softTLB
+
+    ExecEngine engine;		// how to run user code
+    BlockCache *blockCache;	// translated blocks, for BlockEngine
+
+    QuantumRunner *quanta;	// runs the CPUs a quantum at a time, or
+				// NULL to interleave their instructions
+    Machine *parent;		// the main machine, if this one just runs
+				// quanta for it; NULL for the main machine
+    bool wroteFrame[NumPhysPages];
+				// pages written during this quantum
 };
 
 extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
 				// Defined in exception.cc
+extern void PrintSyscallCounts();
+				// Print how often each system call was
+				// made; also defined in exception.cc
 
 
 // Routines for converting Words and Short Words to and from the
@@ -0,0 +1,445 @@
+// quantum.cc
+//	Routines to run the simulated CPUs a quantum at a time, each
+//	(when it is safe) on a host thread of its own.  See quantum.h
+//	for how this stays deterministic.
+//
+//	The main machine, which the kernel uses, only ever holds the
+//	registers of the thread on the current CPU.  Each CPU also has a
+//	machine of its own, which runs its quantum.  Before a round, each
+//	CPU's thread copies its registers over (Publish); after the round,
+//	it copies them back (Collect), when it is next switched to.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "quantum.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// QuantumWorker
+// 	The body of a host thread running one CPU's quanta.  C++ member
+//	functions can't be given to pthread_create directly.
+//
+//	"arg" -- the CPU to run
+//----------------------------------------------------------------------
+
+static void *
+QuantumWorker(void *arg)
+{
+    QuantumCPU *cpu = (QuantumCPU *) arg;
+
+    cpu->runner->WorkerLoop(cpu->id);
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::QuantumRunner
+// 	Initialize the CPUs, each with a machine of its own that shares
+//	memory with the main one.  If asked, and there is more than one
+//	CPU, start a host thread for each.
+//
+//	"main" -- the machine the kernel uses
+//	"howMany" -- the number of simulated CPUs
+//	"ticks" -- the length of a quantum
+//	"hostThreads" -- if TRUE, run the quanta on host threads
+//----------------------------------------------------------------------
+
+QuantumRunner::QuantumRunner(Machine *main, int howMany, int ticks,
+			     bool hostThreads)
+{
+    int i, err;
+
+    ASSERT(ticks >= UserTick);
+    mainMachine = main;
+    numCPUs = howMany;
+    quantum = ticks / UserTick;
+    useHostThreads = hostThreads && (numCPUs > 1);
+    round = 0;
+    running = 0;
+    roundLimit = 0;
+    quit = FALSE;
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&startRound, NULL);
+    pthread_cond_init(&endRound, NULL);
+
+    cpus = new QuantumCPU[numCPUs];
+    for (i = 0; i < numCPUs; i++) {
+	cpus[i].machine = new Machine(main);
+	cpus[i].owner = NULL;
+	cpus[i].published = FALSE;
+	cpus[i].hasResult = FALSE;
+	cpus[i].trapped = FALSE;
+	cpus[i].executed = 0;
+	cpus[i].runner = this;
+	cpus[i].id = i;
+    }
+    if (useHostThreads)
+	for (i = 0; i < numCPUs; i++) {
+	    err = pthread_create(&cpus[i].host, NULL, QuantumWorker, &cpus[i]);
+	    ASSERT(err == 0);
+	}
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::~QuantumRunner
+// 	Stop the host threads, and de-allocate the CPUs.
+//----------------------------------------------------------------------
+
+QuantumRunner::~QuantumRunner()
+{
+    int i;
+
+    if (useHostThreads) {
+	pthread_mutex_lock(&lock);
+	quit = TRUE;
+	pthread_cond_broadcast(&startRound);
+	pthread_mutex_unlock(&lock);
+	for (i = 0; i < numCPUs; i++)
+	    pthread_join(cpus[i].host, NULL);
+    }
+    for (i = 0; i < numCPUs; i++)
+	delete cpus[i].machine;
+    delete [] cpus;
+    pthread_cond_destroy(&endRound);
+    pthread_cond_destroy(&startRound);
+    pthread_mutex_destroy(&lock);
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::Collect
+// 	Called when "thread" is about to run user code on "cpu".  If
+//	"cpu" ran a quantum for it, load the registers it left into the
+//	main machine.  A result left for some other thread is stale --
+//	that thread has since stopped running on "cpu", with its registers
+//	saved -- and is thrown away.
+//
+//	Returns TRUE if the quantum stopped at an instruction that traps,
+//	which the caller must then run on the main machine.
+//----------------------------------------------------------------------
+
+bool
+QuantumRunner::Collect(int cpu, Thread *thread)
+{
+    QuantumCPU *c = &cpus[cpu];
+
+    if (!c->hasResult)
+	return FALSE;
+    c->hasResult = FALSE;
+    if (c->owner != thread)
+	return FALSE;
+    for (int i = 0; i < NumTotalRegs; i++)
+	mainMachine->registers[i] = c->machine->registers[i];
+    return c->trapped;
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::Publish
+// 	Get "cpu" ready to run the user program that is in the main
+//	machine right now, for "thread", during the next round.  The CPU
+//	shares the program's page table (or the CPU's TLB), so it sets
+//	the same use and dirty bits as the main machine would.
+//----------------------------------------------------------------------
+
+void
+QuantumRunner::Publish(int cpu, Thread *thread)
+{
+    QuantumCPU *c = &cpus[cpu];
+    Machine *m = c->machine;
+
+    for (int i = 0; i < NumTotalRegs; i++)
+	m->registers[i] = mainMachine->registers[i];
+    m->tlb = mainMachine->tlb;
+    m->tlbLastUse = mainMachine->tlbLastUse;
+    m->tlbHits = mainMachine->tlbHits;
+    m->pageTable = mainMachine->pageTable;
+    m->pageTableSize = mainMachine->pageTableSize;
+    m->FlushSoftTLB();
+    c->owner = thread;
+    c->published = TRUE;
+    c->hasResult = FALSE;
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::FlushSoftTLBs
+// 	Have every CPU forget the translations it has remembered, because
+//	the kernel is changing a page table other than the current one.
+//	Only called from the kernel, between rounds.
+//----------------------------------------------------------------------
+
+void
+QuantumRunner::FlushSoftTLBs()
+{
+    for (int i = 0; i < numCPUs; i++)
+	cpus[i].machine->FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::RunRound
+// 	Run a quantum on every CPU that has published a program, then
+//	meet at the barrier: advance simulated time by the longest
+//	quantum run, and let any interrupts that are due happen.
+//
+//	No quantum runs past the next pending interrupt, so interrupts
+//	happen at the same tick as they would without quanta.  The
+//	current CPU's registers are loaded into the main machine before
+//	the barrier, since an interrupt may switch its thread out.
+//
+//	"cpu" -- the CPU currently running, which published last
+//----------------------------------------------------------------------
+
+void
+QuantumRunner::RunRound(int cpu)
+{
+    int i, limit, advance;
+
+    limit = (interrupt->NextDueTime() - stats->totalTicks) / UserTick;
+    if (limit > quantum)
+	limit = quantum;
+    if (limit < 1)
+	limit = 1;
+
+    if (useHostThreads && !DebugIsEnabled('a') && CanRunInParallel()) {
+	pthread_mutex_lock(&lock);
+	roundLimit = limit;
+	running = numCPUs;
+	round++;
+	pthread_cond_broadcast(&startRound);
+	while (running > 0)
+	    pthread_cond_wait(&endRound, &lock);
+	pthread_mutex_unlock(&lock);
+	for (i = 0; i < numCPUs; i++)
+	    if (cpus[i].published)
+		cpus[i].machine->PublishWrites();
+    } else
+	for (i = 0; i < numCPUs; i++)
+	    if (cpus[i].published) {
+		RunOne(i, limit);
+		cpus[i].machine->PublishWrites();  // before the next CPU
+	    }					   // runs, in case it shares
+
+    advance = 0;
+    for (i = 0; i < numCPUs; i++)
+	if (cpus[i].published) {
+	    cpus[i].published = FALSE;
+	    cpus[i].hasResult = TRUE;
+	    if (cpus[i].executed > advance)
+		advance = cpus[i].executed;
+	}
+    DEBUG('i', "Quantum round of %d instructions\n", advance);
+
+    for (i = 0; i < NumTotalRegs; i++)		// keep hasResult, for the
+	mainMachine->registers[i] =		// trapped flag
+			cpus[cpu].machine->registers[i];
+    if (advance > 0) {
+	stats->totalTicks += (advance - 1) * UserTick;	// OneTick adds
+	stats->userTicks += (advance - 1) * UserTick;	// the last one
+	interrupt->OneTick();
+    }
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::WorkerLoop
+// 	Run "cpu"'s quantum each time a round starts, until the runner
+//	is deleted.  Runs on a host thread of its own.
+//----------------------------------------------------------------------
+
+void
+QuantumRunner::WorkerLoop(int cpu)
+{
+    int seen = 0;
+
+    pthread_mutex_lock(&lock);
+    for (;;) {
+	while ((round == seen) && !quit)
+	    pthread_cond_wait(&startRound, &lock);
+	if (quit)
+	    break;
+	seen = round;
+	pthread_mutex_unlock(&lock);
+
+	if (cpus[cpu].published)
+	    RunOne(cpu, roundLimit);
+
+	pthread_mutex_lock(&lock);
+	if (--running == 0)
+	    pthread_cond_signal(&endRound);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::RunOne
+// 	Run one CPU's quantum, of at most "limit" instructions.
+//----------------------------------------------------------------------
+
+void
+QuantumRunner::RunOne(int cpu, int limit)
+{
+    QuantumCPU *c = &cpus[cpu];
+
+    c->machine->SyncCode();
+    c->executed = c->machine->RunQuantum(limit, &c->trapped);
+}
+
+//----------------------------------------------------------------------
+// NoteFrames
+// 	Record that CPU "cpu" maps the frames of the "size" translation
+//	entries at "entries": in "user", which CPU maps each frame (-2 if
+//	more than one does), and in "writable", whether any can write it.
+//----------------------------------------------------------------------
+
+static void
+NoteFrames(TranslationEntry *entries, int size, int cpu, int *user,
+	   bool *writable)
+{
+    int frame;
+
+    for (int j = 0; j < size; j++) {
+	frame = entries[j].physicalPage;
+	if (!entries[j].valid || (frame < 0) || (frame >= NumPhysPages))
+	    continue;
+	if (user[frame] == -1)
+	    user[frame] = cpu;
+	else if (user[frame] != cpu)
+	    user[frame] = -2;
+	if (!entries[j].readOnly)
+	    writable[frame] = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// QuantumRunner::CanRunInParallel
+// 	Return TRUE if the published CPUs can run at the same time
+//	without the result depending on the order: no physical page is
+//	mapped by two CPUs, and writable by either of them.  (Pages
+//	shared read-only, such as code, are fine.)
+//----------------------------------------------------------------------
+
+bool
+QuantumRunner::CanRunInParallel()
+{
+    int user[NumPhysPages];	// the CPU mapping each page, -1 if none,
+				// -2 if more than one
+    bool writable[NumPhysPages];
+    Machine *m;
+    int i, leaf, frame;
+
+    for (frame = 0; frame < NumPhysPages; frame++) {
+	user[frame] = -1;
+	writable[frame] = FALSE;
+    }
+    for (i = 0; i < numCPUs; i++) {
+	if (!cpus[i].published)
+	    continue;
+	m = cpus[i].machine;
+	if (m->tlb != NULL)
+	    NoteFrames(m->tlb, m->tlbSize, i, user, writable);
+	else
+	    for (leaf = 0; leaf < (int) divRoundUp(m->pageTableSize, LeafSize);
+								leaf++)
+		if (m->pageTable[leaf] != NULL)
+		    NoteFrames(m->pageTable[leaf], LeafSize, i, user,
+			       writable);
+    }
+    for (frame = 0; frame < NumPhysPages; frame++)
+	if ((user[frame] == -2) && writable[frame])
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunQuanta
+// 	Simulate the execution of user-level programs on every CPU, a
+//	quantum at a time.  Called by Run; never returns.
+//
+//	Each time a CPU's thread gets its turn, it picks up what its last
+//	quantum did (running the instruction it stopped at, if that
+//	traps), yields if the timer said to meanwhile, and publishes its
+//	registers for the next round.  The last
+//	busy CPU in the round then runs the round.
+//----------------------------------------------------------------------
+
+void
+Machine::RunQuanta()
+{
+    for (;;) {
+	if (quanta->Collect(scheduler->CurrentCPU(), currentThread)) {
+	    OneInstruction();			// raises the exception
+	    interrupt->OneTick();
+	}
+	scheduler->YieldIfDue();
+	quanta->Publish(scheduler->CurrentCPU(), currentThread);
+	if (scheduler->LastInRound())
+	    quanta->RunRound(scheduler->CurrentCPU());
+	scheduler->NextCPU();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunQuantum
+// 	Run up to "limit" instructions of a quantum, on a machine made by
+//	Machine(Machine *).  We stop before any instruction that raises
+//	an exception: RaiseException does nothing here, and Execute makes
+//	no change to the registers or memory before it raises one, so the
+//	main machine can simply run the instruction again.
+//
+//	Returns the number of instructions run.
+//
+//	"limit" -- the most instructions to run
+//	"trapped" -- set to TRUE if we stopped at an exception
+//----------------------------------------------------------------------
+
+int
+Machine::RunQuantum(int limit, bool *trapped)
+{
+    Instruction *instr;
+    int n;
+
+    ASSERT(parent != NULL);
+    *trapped = FALSE;
+    for (n = 0; n < limit; n++) {
+	instr = FetchInstruction(registers[PCReg]);
+	if ((instr == NULL) || !Execute(instr)) {
+	    *trapped = TRUE;
+	    break;
+	}
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// Machine::SyncCode
+// 	Throw away any decoded instructions from pages that have changed
+//	since the last quantum, according to the main machine.
+//----------------------------------------------------------------------
+
+void
+Machine::SyncCode()
+{
+    for (int frame = 0; frame < NumPhysPages; frame++)
+	if (codeVersion[frame] != parent->codeVersion[frame]) {
+	    codeVersion[frame] = parent->codeVersion[frame];
+	    if (decodeCache[frame] != NULL)
+		for (int i = 0; i < InstrsPerPage; i++)
+		    decodeCache[frame][i].opCode = 0;
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::PublishWrites
+// 	Tell the main machine about the pages the last quantum wrote to,
+//	so that it (and the other CPUs, at their next SyncCode) throws
+//	away instructions decoded from them.
+//----------------------------------------------------------------------
+
+void
+Machine::PublishWrites()
+{
+    for (int frame = 0; frame < NumPhysPages; frame++)
+	if (wroteFrame[frame]) {
+	    wroteFrame[frame] = FALSE;
+	    parent->InvalidateCodePage(frame);
+	}
+}
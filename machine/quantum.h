@@ -0,0 +1,104 @@
+// quantum.h
+//	Data structures for running the simulated CPUs a quantum at a
+//	time, optionally each on its own host thread.
+//
+//	Normally the CPUs take turns one instruction at a time (see
+//	Scheduler::NextCPU).  In quantum mode, each CPU with a user
+//	thread instead runs up to a whole quantum of instructions on a
+//	machine of its own (made by Machine(Machine *)), which shares
+//	physical memory with the main machine but has its own registers
+//	and caches.  When every CPU has run its quantum, they meet at a
+//	barrier, where simulated time advances and interrupts are handled.
+//
+//	A CPU stops early, before the instruction, if the instruction
+//	would trap to the kernel; the main machine then runs it again
+//	the ordinary way, so the kernel only ever runs on the main host
+//	thread, one CPU at a time.
+//
+//	The result does not depend on whether the CPUs run on host threads:
+//	they run in parallel only when no CPU can write a page that any
+//	other CPU can see, and otherwise run one after another in CPU
+//	order.  Since a quantum never includes kernel code, a CPU's
+//	quantum then depends only on its own registers and pages.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef QUANTUM_H
+#define QUANTUM_H
+
+#include "copyright.h"
+#include "machine.h"
+#include <pthread.h>
+
+class Thread;
+class QuantumRunner;
+
+// The following class records the state of one CPU in quantum mode.
+
+class QuantumCPU {
+  public:
+    Machine *machine;		// runs this CPU's quantum
+    Thread *owner;		// the thread whose registers "machine" has
+    bool published;		// TRUE if "machine" should run next round
+    bool hasResult;		// TRUE if it ran and "owner" hasn't
+				// picked up the result yet
+    bool trapped;		// TRUE if it stopped because the next
+				// instruction traps
+    int executed;		// instructions run in the last round
+
+    QuantumRunner *runner;	// the runner this CPU belongs to
+    int id;			// which CPU this is
+    pthread_t host;		// the host thread running this CPU, if any
+};
+
+// The following class runs the quanta of all the CPUs.
+
+class QuantumRunner {
+  public:
+    QuantumRunner(Machine *main, int howMany, int ticks, bool hostThreads);
+				// Initialize the CPUs; start a host thread
+				// for each, if "hostThreads"
+    ~QuantumRunner();		// Stop the host threads, de-allocate
+
+    bool Collect(int cpu, Thread *thread);
+				// Give "thread" the registers its last
+				// quantum on "cpu" left; return TRUE if
+				// the next instruction traps
+    void Publish(int cpu, Thread *thread);
+				// Have "cpu" run the user program in the
+				// main machine's registers next round
+    void RunRound(int cpu);
+				// Run a quantum on every published CPU,
+				// then advance time to the barrier;
+				// "cpu" is the one currently running
+
+    void FlushSoftTLBs();	// Have every CPU forget the translations
+				// its ReadMem and WriteMem remembered
+
+    void WorkerLoop(int cpu);	// Internal routine, run by each host
+				// thread until the runner is deleted
+
+  private:
+    bool CanRunInParallel();	// Do the published CPUs share no
+				// writable memory?
+    void RunOne(int cpu, int limit);
+				// Run one CPU's quantum
+
+    Machine *mainMachine;	// the machine running the kernel
+    int numCPUs;
+    int quantum;		// instructions per CPU per round
+    bool useHostThreads;	// run quanta on host threads, if possible
+    QuantumCPU *cpus;
+
+    pthread_mutex_t lock;	// protects the fields below
+    pthread_cond_t startRound;	// signalled when a round starts
+    pthread_cond_t endRound;	// signalled when a worker finishes
+    int round;			// number of rounds started
+    int running;		// workers still running this round
+    int roundLimit;		// instructions each CPU may run this round
+    bool quit;			// TRUE when the workers should stop
+};
+
+#endif // QUANTUM_H
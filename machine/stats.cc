@@ -20,8 +20,34 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
-    numConsoleCharsRead = numConsoleCharsWritten = 0;
+    numConsoleCharsRead = numConsoleCharsWritten = numConsoleWriteInts = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageOuts = numSwapReads = numSwapWrites = 0;
+    numTLBHits = numTLBMisses = 0;
+    numDispatches = readyWaitTicks = maxReadyWait = 0;
+    for (int i = 0; i < WaitBuckets; i++)
+	readyWaits[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Statistics::NoteReadyWait
+// 	Count a thread being run, after it had been ready for "wait"
+//	ticks.  The waits are kept by power of two, so that Print can
+//	tell how long most threads waited, as well as the longest.
+//----------------------------------------------------------------------
+
+void
+Statistics::NoteReadyWait(int wait)
+{
+    int bucket = 0;
+
+    numDispatches++;
+    readyWaitTicks += wait;
+    if (wait > maxReadyWait)
+	maxReadyWait = wait;
+    while ((wait >> bucket) != 0)
+	bucket++;
+    readyWaits[bucket]++;
 }
 
 //----------------------------------------------------------------------
@@ -36,9 +62,24 @@ Statistics::Print()
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
-    printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
-	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Console I/O: reads %d, writes %d, write interrupts %d\n",
+	numConsoleCharsRead, numConsoleCharsWritten, numConsoleWriteInts);
+    printf("Paging: faults %d, evictions %d, swap reads %d, writes %d\n",
+	numPageFaults, numPageOuts, numSwapReads, numSwapWrites);
+    printf("TLB: hits %d, misses %d\n", numTLBHits, numTLBMisses);
+    if (numDispatches > 0) {
+	int bucket, count = 0;
+
+	// the 99th percentile is in the first bucket that gets us there
+	for (bucket = 0; bucket < WaitBuckets - 1; bucket++) {
+	    count += readyWaits[bucket];
+	    if (count * 100 >= numDispatches * 99)
+		break;
+	}
+	printf("Scheduling: dispatches %d, ready wait mean %d, 99%% under %d, "
+		"max %d\n", numDispatches, readyWaitTicks / numDispatches,
+		1 << bucket, maxReadyWait);
+    }
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
@@ -13,6 +13,8 @@
 
 #include "copyright.h"
 
+#define WaitBuckets	32	// ready waits are counted by power of two
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -32,12 +34,25 @@ class Statistics {
     int numDiskWrites;		// number of disk write requests
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
+    int numConsoleWriteInts;	// number of display interrupts it took
     int numPageFaults;		// number of virtual memory page faults
+    int numPageOuts;		// number of pages evicted from memory
+    int numSwapReads;		// number of pages read in from swap
+    int numSwapWrites;		// number of pages written out to swap
+    int numTLBHits;		// number of translations found in a TLB
+    int numTLBMisses;		// number of TLB misses refilled by the kernel
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numDispatches;		// number of times a ready thread was run
+    int readyWaitTicks;		// total time threads waited while ready
+    int maxReadyWait;		// the longest one waited
+    int readyWaits[WaitBuckets];	// how many waited less than 2^i ticks,
+					// but not less than 2^(i-1)
 
     Statistics(); 		// initialize everything to zero
 
+    void NoteReadyWait(int wait);	// a ready thread was run after
+					// waiting "wait" ticks
     void Print();		// print collected statistics
 };
 
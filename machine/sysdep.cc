@@ -492,3 +492,37 @@ DeallocBoundedArray(char *ptr, int size)
     mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
     delete [] (ptr - pgSize);
 }
+
+//----------------------------------------------------------------------
+// AllocExecutable
+// 	Return memory that code can be written into and then run, for
+//	translating user programs into host instructions.  Returns NULL if
+//	the host won't give us any.
+//
+//	"size" -- amount of space needed (in bytes)
+//----------------------------------------------------------------------
+
+char *
+AllocExecutable(int size)
+{
+    char *ptr = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+				MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    if (ptr == (char *) MAP_FAILED)
+	return NULL;
+    return ptr;
+}
+
+//----------------------------------------------------------------------
+// DeallocExecutable
+// 	Give back memory returned by AllocExecutable.
+//
+//	"ptr" -- the memory to be deallocated
+//	"size" -- its size (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocExecutable(char *ptr, int size)
+{
+    munmap(ptr, size);
+}
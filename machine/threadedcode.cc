@@ -0,0 +1,505 @@
+// threadedcode.cc
+//	A second interpreter for user programs, using threaded code.
+//
+//	Machine::OneInstruction dispatches on the opcode with one big
+//	switch statement, so every instruction goes through the same
+//	indirect jump, which the host can rarely predict.  Here, instead,
+//	each instruction has its own handler, and each handler ends by
+//	fetching the next instruction and jumping straight to its handler.
+//	The handler's address is kept in the decoded instruction cache,
+//	so after the first time, the only cost of dispatch is that jump.
+//
+//	This relies on the GNU C "labels as values" extension (computed
+//	goto), which g++ supports on all of our hosts.
+//
+//	The handlers must do exactly what the cases in Machine::Execute
+//	do; if you change one, change the other.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "system.h"
+
+// Fetch the instruction at the PC and jump to its handler.
+#define FETCH() 							\
+    if ((instr = FetchInstruction(registers[PCReg])) == NULL)		\
+	goto exception;							\
+    pcAfter = registers[NextPCReg] + 4;					\
+    nextLoadReg = 0;							\
+    nextLoadValue = 0;							\
+    if (instr->handler == NULL)						\
+	instr->handler = handlers[(int) instr->opCode];			\
+    goto *instr->handler
+
+// The instruction completed: do any delayed load, advance the program
+// counters, let simulated time pass, and go on to the next instruction.
+#define NEXT()								\
+    DelayedLoad(nextLoadReg, nextLoadValue);				\
+    registers[PrevPCReg] = registers[PCReg];				\
+    registers[PCReg] = registers[NextPCReg];				\
+    registers[NextPCReg] = pcAfter;					\
+    interrupt->OneTick();						\
+    FETCH()
+
+// Taken branch
+#define BRANCH()							\
+    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra)
+
+//----------------------------------------------------------------------
+// Machine::RunThreaded
+// 	Simulate the execution of a user-level program, using threaded
+//	code.  Called by Run; never returns.
+//
+//	On an exception, the exception handler has already been called by
+//	the time we get control back, so all that's left is to charge the
+//	tick, as Run does, and fetch whatever the PC now points to.
+//----------------------------------------------------------------------
+
+void
+Machine::RunThreaded()
+{
+    static void *handlers[MaxOpcode + 1] = {
+	&&bad,   &&add,   &&addi,  &&addiu, &&addu,  &&and_,  &&andi,  &&beq,
+	&&bgez,  &&bgezal, &&bgtz, &&blez,  &&bltz,  &&bltzal, &&bne,  &&bad,
+	&&div,   &&divu,  &&j,     &&jal,   &&jalr,  &&jr,    &&lb,    &&lbu,
+	&&lh,    &&lhu,   &&lui,   &&lw,    &&lwl,   &&lwr,   &&bad,   &&mfhi,
+	&&mflo,  &&bad,   &&mthi,  &&mtlo,  &&mult,  &&multu, &&nor,   &&or_,
+	&&ori,   &&bad,   &&sb,    &&sh,    &&sll,   &&sllv,  &&slt,   &&slti,
+	&&sltiu, &&sltu,  &&sra,   &&srav,  &&srl,   &&srlv,  &&sub,   &&subu,
+	&&sw,    &&swl,   &&swr,   &&xor_,  &&xori,  &&syscall, &&illegal,
+	&&illegal
+    };
+    Instruction *instr;
+    int nextLoadReg, nextLoadValue, pcAfter;
+    int sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+
+    FETCH();
+
+  exception:
+    interrupt->OneTick();
+    FETCH();
+
+  add:
+    sum = registers[(int) instr->rs] + registers[(int) instr->rt];
+    if (!((registers[(int) instr->rs] ^ registers[(int) instr->rt])
+		& SIGN_BIT) &&
+	((registers[(int) instr->rs] ^ sum) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	goto exception;
+    }
+    registers[(int) instr->rd] = sum;
+    NEXT();
+
+  addi:
+    sum = registers[(int) instr->rs] + instr->extra;
+    if (!((registers[(int) instr->rs] ^ instr->extra) & SIGN_BIT) &&
+	((instr->extra ^ sum) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	goto exception;
+    }
+    registers[(int) instr->rt] = sum;
+    NEXT();
+
+  addiu:
+    registers[(int) instr->rt] = registers[(int) instr->rs] + instr->extra;
+    NEXT();
+
+  addu:
+    registers[(int) instr->rd] =
+		registers[(int) instr->rs] + registers[(int) instr->rt];
+    NEXT();
+
+  and_:
+    registers[(int) instr->rd] =
+		registers[(int) instr->rs] & registers[(int) instr->rt];
+    NEXT();
+
+  andi:
+    registers[(int) instr->rt] =
+		registers[(int) instr->rs] & (instr->extra & 0xffff);
+    NEXT();
+
+  beq:
+    if (registers[(int) instr->rs] == registers[(int) instr->rt])
+	BRANCH();
+    NEXT();
+
+  bgezal:
+    registers[R31] = registers[NextPCReg] + 4;
+  bgez:
+    if (!(registers[(int) instr->rs] & SIGN_BIT))
+	BRANCH();
+    NEXT();
+
+  bgtz:
+    if (registers[(int) instr->rs] > 0)
+	BRANCH();
+    NEXT();
+
+  blez:
+    if (registers[(int) instr->rs] <= 0)
+	BRANCH();
+    NEXT();
+
+  bltzal:
+    registers[R31] = registers[NextPCReg] + 4;
+  bltz:
+    if (registers[(int) instr->rs] & SIGN_BIT)
+	BRANCH();
+    NEXT();
+
+  bne:
+    if (registers[(int) instr->rs] != registers[(int) instr->rt])
+	BRANCH();
+    NEXT();
+
+  div:
+    if (registers[(int) instr->rt] == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	registers[LoReg] =  registers[(int) instr->rs] / registers[(int) instr->rt];
+	registers[HiReg] = registers[(int) instr->rs] % registers[(int) instr->rt];
+    }
+    NEXT();
+
+  divu:
+    rs = (unsigned int) registers[(int) instr->rs];
+    rt = (unsigned int) registers[(int) instr->rt];
+    if (rt == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	tmp = rs / rt;
+	registers[LoReg] = (int) tmp;
+	tmp = rs % rt;
+	registers[HiReg] = (int) tmp;
+    }
+    NEXT();
+
+  jal:
+    registers[R31] = registers[NextPCReg] + 4;
+  j:
+    pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
+    NEXT();
+
+  jalr:
+    registers[(int) instr->rd] = registers[NextPCReg] + 4;
+  jr:
+    pcAfter = registers[(int) instr->rs];
+    NEXT();
+
+  lb:
+  lbu:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (!ReadMem(tmp, 1, &value))
+	goto exception;
+    if ((value & 0x80) && (instr->opCode == OP_LB))
+	value |= 0xffffff00;
+    else
+	value &= 0xff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT();
+
+  lh:
+  lhu:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (tmp & 0x1) {
+	RaiseException(AddressErrorException, tmp);
+	goto exception;
+    }
+    if (!ReadMem(tmp, 2, &value))
+	goto exception;
+    if ((value & 0x8000) && (instr->opCode == OP_LH))
+	value |= 0xffff0000;
+    else
+	value &= 0xffff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT();
+
+  lui:
+    registers[(int) instr->rt] = instr->extra << 16;
+    NEXT();
+
+  lw:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    if (tmp & 0x3) {
+	RaiseException(AddressErrorException, tmp);
+	goto exception;
+    }
+    if (!ReadMem(tmp, 4, &value))
+	goto exception;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT();
+
+  lwl:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see Machine::Execute
+    if (!ReadMem(tmp, 4, &value))
+	goto exception;
+    if (registers[LoadReg] == instr->rt)
+	nextLoadValue = registers[LoadValueReg];
+    else
+	nextLoadValue = registers[(int) instr->rt];
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = value;
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
+	break;
+      case 3:
+	nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT();
+
+  lwr:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see Machine::Execute
+    if (!ReadMem(tmp, 4, &value))
+	goto exception;
+    if (registers[LoadReg] == instr->rt)
+	nextLoadValue = registers[LoadValueReg];
+    else
+	nextLoadValue = registers[(int) instr->rt];
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = (nextLoadValue & 0xffffff00) |
+	    ((value >> 24) & 0xff);
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xffff0000) |
+	    ((value >> 16) & 0xffff);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xff000000)
+	    | ((value >> 8) & 0xffffff);
+	break;
+      case 3:
+	nextLoadValue = value;
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT();
+
+  mfhi:
+    registers[(int) instr->rd] = registers[HiReg];
+    NEXT();
+
+  mflo:
+    registers[(int) instr->rd] = registers[LoReg];
+    NEXT();
+
+  mthi:
+    registers[HiReg] = registers[(int) instr->rs];
+    NEXT();
+
+  mtlo:
+    registers[LoReg] = registers[(int) instr->rs];
+    NEXT();
+
+  mult:
+    Mult(registers[(int) instr->rs], registers[(int) instr->rt], TRUE,
+	 &registers[HiReg], &registers[LoReg]);
+    NEXT();
+
+  multu:
+    Mult(registers[(int) instr->rs], registers[(int) instr->rt], FALSE,
+	 &registers[HiReg], &registers[LoReg]);
+    NEXT();
+
+  nor:
+    registers[(int) instr->rd] =
+		~(registers[(int) instr->rs] | registers[(int) instr->rt]);
+    NEXT();
+
+  or_:					// same as Machine::Execute
+    registers[(int) instr->rd] =
+		registers[(int) instr->rs] | registers[(int) instr->rs];
+    NEXT();
+
+  ori:
+    registers[(int) instr->rt] =
+		registers[(int) instr->rs] | (instr->extra & 0xffff);
+    NEXT();
+
+  sb:
+    if (!WriteMem((unsigned)
+		(registers[(int) instr->rs] + instr->extra), 1, registers[(int) instr->rt]))
+	goto exception;
+    NEXT();
+
+  sh:
+    if (!WriteMem((unsigned)
+		(registers[(int) instr->rs] + instr->extra), 2, registers[(int) instr->rt]))
+	goto exception;
+    NEXT();
+
+  sll:
+    registers[(int) instr->rd] = registers[(int) instr->rt] << instr->extra;
+    NEXT();
+
+  sllv:
+    registers[(int) instr->rd] = registers[(int) instr->rt] <<
+	(registers[(int) instr->rs] & 0x1f);
+    NEXT();
+
+  slt:
+    if (registers[(int) instr->rs] < registers[(int) instr->rt])
+	registers[(int) instr->rd] = 1;
+    else
+	registers[(int) instr->rd] = 0;
+    NEXT();
+
+  slti:
+    if (registers[(int) instr->rs] < instr->extra)
+	registers[(int) instr->rt] = 1;
+    else
+	registers[(int) instr->rt] = 0;
+    NEXT();
+
+  sltiu:
+    rs = registers[(int) instr->rs];
+    imm = instr->extra;
+    if (rs < imm)
+	registers[(int) instr->rt] = 1;
+    else
+	registers[(int) instr->rt] = 0;
+    NEXT();
+
+  sltu:
+    rs = registers[(int) instr->rs];
+    rt = registers[(int) instr->rt];
+    if (rs < rt)
+	registers[(int) instr->rd] = 1;
+    else
+	registers[(int) instr->rd] = 0;
+    NEXT();
+
+  sra:
+    registers[(int) instr->rd] = registers[(int) instr->rt] >> instr->extra;
+    NEXT();
+
+  srav:
+    registers[(int) instr->rd] = registers[(int) instr->rt] >>
+	(registers[(int) instr->rs] & 0x1f);
+    NEXT();
+
+  srl:
+    tmp = registers[(int) instr->rt];
+    tmp >>= instr->extra;
+    registers[(int) instr->rd] = tmp;
+    NEXT();
+
+  srlv:
+    tmp = registers[(int) instr->rt];
+    tmp >>= (registers[(int) instr->rs] & 0x1f);
+    registers[(int) instr->rd] = tmp;
+    NEXT();
+
+  sub:
+    diff = registers[(int) instr->rs] - registers[(int) instr->rt];
+    if (((registers[(int) instr->rs] ^ registers[(int) instr->rt])
+		& SIGN_BIT) &&
+	((registers[(int) instr->rs] ^ diff) & SIGN_BIT)) {
+	RaiseException(OverflowException, 0);
+	goto exception;
+    }
+    registers[(int) instr->rd] = diff;
+    NEXT();
+
+  subu:
+    registers[(int) instr->rd] =
+		registers[(int) instr->rs] - registers[(int) instr->rt];
+    NEXT();
+
+  sw:
+    if (!WriteMem((unsigned)
+		(registers[(int) instr->rs] + instr->extra), 4, registers[(int) instr->rt]))
+	goto exception;
+    NEXT();
+
+  swl:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see Machine::Execute
+    if (!ReadMem((tmp & ~0x3), 4, &value))
+	goto exception;
+    switch (tmp & 0x3) {
+      case 0:
+	value = registers[(int) instr->rt];
+	break;
+      case 1:
+	value = (value & 0xff000000) | ((registers[(int) instr->rt] >> 8) &
+					0xffffff);
+	break;
+      case 2:
+	value = (value & 0xffff0000) | ((registers[(int) instr->rt] >> 16) &
+					0xffff);
+	break;
+      case 3:
+	value = (value & 0xffffff00) | ((registers[(int) instr->rt] >> 24) &
+					0xff);
+	break;
+    }
+    if (!WriteMem((tmp & ~0x3), 4, value))
+	goto exception;
+    NEXT();
+
+  swr:
+    tmp = registers[(int) instr->rs] + instr->extra;
+    ASSERT((tmp & 0x3) == 0);		// see Machine::Execute
+    if (!ReadMem((tmp & ~0x3), 4, &value))
+	goto exception;
+    switch (tmp & 0x3) {
+      case 0:
+	value = (value & 0xffffff) | (registers[(int) instr->rt] << 24);
+	break;
+      case 1:
+	value = (value & 0xffff) | (registers[(int) instr->rt] << 16);
+	break;
+      case 2:
+	value = (value & 0xff) | (registers[(int) instr->rt] << 8);
+	break;
+      case 3:
+	value = registers[(int) instr->rt];
+	break;
+    }
+    if (!WriteMem((tmp & ~0x3), 4, value))
+	goto exception;
+    NEXT();
+
+  syscall:
+    RaiseException(SyscallException, 0);
+    goto exception;
+
+  xor_:
+    registers[(int) instr->rd] =
+		registers[(int) instr->rs] ^ registers[(int) instr->rt];
+    NEXT();
+
+  xori:
+    registers[(int) instr->rt] =
+		registers[(int) instr->rs] ^ (instr->extra & 0xffff);
+    NEXT();
+
+  illegal:
+    RaiseException(IllegalInstrException, 0);
+    goto exception;
+
+  bad:
+    ASSERT(FALSE);
+    goto exception;
+}
@@ -48,8 +48,10 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
     arg = callArg; 
 
     // schedule the first interrupt from the timer device
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt); 
+    int delay = TimeOfNextInterrupt();
+    due = stats->totalTicks + delay;
+    skipping = FALSE;
+    interrupt->Schedule(TimerHandler, (int) this, delay, TimerInt); 
 }
 
 //----------------------------------------------------------------------
@@ -57,18 +59,91 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
 //      Routine to simulate the interrupt generated by the hardware 
 //	timer device.  Schedule the next interrupt, and invoke the
 //	interrupt handler.
+//
+//	An interrupt that comes before "due" was superseded by SkipUntil
+//	or WakeBy (we can't take an interrupt back once it is scheduled),
+//	and is ignored.
 //----------------------------------------------------------------------
 void 
 Timer::TimerExpired() 
 {
+    if (stats->totalTicks < due)
+	return;
+
     // schedule the next timer device interrupt
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt);
+    int delay = TimeOfNextInterrupt();
+    due = stats->totalTicks + delay;
+    skipping = FALSE;
+    interrupt->Schedule(TimerHandler, (int) this, delay, TimerInt);
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
 }
 
+//----------------------------------------------------------------------
+// Timer::SkipUntil
+//      A hint from the kernel, while it is idle, that it has nothing
+//	for the timer to do until "when"; so rather than interrupting
+//	regularly until then, the timer next interrupts at "when".
+//	Ignored if the timer was going to interrupt later anyway.
+//
+//	"when" -- the time of the next interrupt the kernel needs
+//----------------------------------------------------------------------
+
+void
+Timer::SkipUntil(int when)
+{
+    if ((when <= due) || (when == NeverDue))
+	return;
+    due = when;
+    skipping = TRUE;
+    interrupt->Schedule(TimerHandler, (int) this, when - stats->totalTicks,
+		TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Timer::WakeBy
+//      Make sure the timer interrupts no later than "when", because the
+//	kernel will have something to do then (e.g., a thread to wake up).
+//	Only matters after SkipUntil; otherwise the timer is never more
+//	than one interval away.
+//
+//	"when" -- the latest time the timer should next interrupt
+//----------------------------------------------------------------------
+
+void
+Timer::WakeBy(int when)
+{
+    if (when >= due)
+	return;
+    if (when <= stats->totalTicks)
+	when = stats->totalTicks + 1;
+    due = when;
+    interrupt->Schedule(TimerHandler, (int) this, when - stats->totalTicks,
+		TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Timer::Resume
+//      The kernel is no longer idle (e.g., a device interrupt has made a
+//	thread ready to run), so it needs regular interrupts again for
+//	time-slicing.  Undoes SkipUntil: the timer next interrupts one
+//	interval from now, rather than whenever the kernel said it would
+//	next have something to do.
+//
+//	Returns TRUE if the timer had been skipping interrupts.
+//----------------------------------------------------------------------
+
+bool
+Timer::Resume()
+{
+    if (!skipping)
+	return FALSE;
+    WakeBy(stats->totalTicks + TimeOfNextInterrupt());
+    skipping = FALSE;
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // Timer::TimeOfNextInterrupt
 //      Return when the hardware timer device will next cause an interrupt.
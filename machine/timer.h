@@ -31,6 +31,14 @@ class Timer {
 				// handler "timerHandler" every time slice.
     ~Timer() {}
 
+    void SkipUntil(int when);	// The kernel won't need an interrupt
+				// before "when", if it stays idle
+    void WakeBy(int when);	// The kernel needs an interrupt no
+				// later than "when"
+    bool Resume();		// The kernel is busy again: go back to
+				// regular interrupts, if skipping them;
+				// TRUE if it was
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
@@ -43,6 +51,9 @@ class Timer {
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
     int arg;			// argument to pass to interrupt handler
+    int due;			// when the next interrupt that counts
+				// is due; any earlier one is ignored
+    bool skipping;		// has SkipUntil put "due" off?
 
 };
 
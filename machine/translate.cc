@@ -6,8 +6,10 @@
 //
 // Two types of translation are supported here.
 //
-//	Linear page table -- the virtual page # is used as an index
-//	into the table, to find the physical page #.
+//	Two-level page table -- the high bits of the virtual page # are
+//	used as an index into a directory, to find a leaf of the table;
+//	the low bits, as an index into the leaf, to find the physical
+//	page #.  Parts of the address space with no leaf are unmapped.
 //
 //	Translation lookaside buffer -- associative lookup in the table
 //	to find an entry with the same virtual page #.  If found,
@@ -90,27 +92,37 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    int vpn = (unsigned) addr / PageSize;
+    SoftTranslation *soft = &softTLB[vpn % SoftTLBSize];
     
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+    if ((soft->virtualPage == vpn) && !(addr & (size - 1))) {
+	if (soft->tlbEntry != -1)
+	    tlbLastUse[soft->tlbEntry] = ++*tlbHits;
+	physicalAddress = soft->physicalPage * PageSize
+					+ (unsigned) addr % PageSize;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	RememberTranslation(addr, physicalAddress, FALSE);
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = mainMemory[physicalAddress];
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) &mainMemory[physicalAddress];
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) &mainMemory[physicalAddress];
 	*value = WordToHost(data);
 	break;
 
@@ -139,26 +151,44 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    int vpn = (unsigned) addr / PageSize;
+    SoftTranslation *soft = &softTLB[vpn % SoftTLBSize];
      
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+    if ((soft->virtualPage == vpn) && soft->writable && !(addr & (size - 1))) {
+	if (soft->tlbEntry != -1)
+	    tlbLastUse[soft->tlbEntry] = ++*tlbHits;
+	physicalAddress = soft->physicalPage * PageSize
+					+ (unsigned) addr % PageSize;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	RememberTranslation(addr, physicalAddress, TRUE);
     }
+    if (decodeCache[physicalAddress / PageSize] != NULL) {  // code page?
+	decodeCache[physicalAddress / PageSize]
+		[(physicalAddress % PageSize) / 4].opCode = 0;
+	codeVersion[physicalAddress / PageSize]++;
+    } else if (quanta != NULL)		// maybe some other CPU's code
+	codeVersion[physicalAddress / PageSize]++;
+    if (parent != NULL)			// tell the main machine, later
+	wroteFrame[physicalAddress / PageSize] = TRUE;
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) &mainMemory[physicalAddress]
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) &mainMemory[physicalAddress]
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -168,6 +198,48 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::RememberTranslation
+//      Remember a translation that Translate has just done for ReadMem
+//	or WriteMem, so that later accesses to the same page can skip it.
+//
+//	Translate has already set the use bit, and for a write, the dirty
+//	bit; until the kernel flushes the soft TLB, there is nothing more
+//	for it to do on that page.  A translation done for a read can't
+//	be used for writes, so that the first write to a clean or
+//	read-only page still goes through Translate.
+//
+//	With a TLB, we also remember which entry the translation came
+//	from, so that each later access counts as a hit on it, as it
+//	would have in Translate; LRU replacement depends on that.
+//
+//	Nothing is remembered while address translation is being traced
+//	(the 'a' debug flag).
+//
+//	"virtAddr" -- the virtual address that was translated
+//	"physAddr" -- the physical address it translated to
+//	"writing" -- TRUE if the translation was done for a write
+//----------------------------------------------------------------------
+
+void
+Machine::RememberTranslation(int virtAddr, int physAddr, bool writing)
+{
+    int vpn = (unsigned) virtAddr / PageSize;
+    SoftTranslation *soft = &softTLB[vpn % SoftTLBSize];
+
+    if (DebugIsEnabled('a'))
+	return;
+    soft->virtualPage = vpn;
+    soft->physicalPage = physAddr / PageSize;
+    soft->writable = writing;
+    soft->tlbEntry = -1;
+    for (int i = 0; i < tlbSize; i++)
+	if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
+	    soft->tlbEntry = i;
+	    break;
+	}
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -188,7 +260,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
     int i;
     unsigned int vpn, offset;
-    TranslationEntry *entry;
+    TranslationEntry *entry, *leaf;
     unsigned int pageFrame;
 
     DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
@@ -208,21 +280,23 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
     
-    if (tlb == NULL) {		// => page table => vpn is index into table
+    if (tlb == NULL) {		// => page table => vpn indexes directory, leaf
 	if (vpn >= pageTableSize) {
 	    DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
 			virtAddr, pageTableSize);
 	    return AddressErrorException;
-	} else if (!pageTable[vpn].valid) {
-	    DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
-			virtAddr, pageTableSize);
+	}
+	leaf = pageTable[vpn >> LeafBits];
+	if ((leaf == NULL) || !leaf[vpn % LeafSize].valid) {
+	    DEBUG('a', "virtual page # %d not in memory!\n", vpn);
 	    return PageFaultException;
 	}
-	entry = &pageTable[vpn];
+	entry = &leaf[vpn % LeafSize];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
+        for (entry = NULL, i = 0; i < tlbSize; i++)
     	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
 		entry = &tlb[i];			// FOUND!
+		tlbLastUse[i] = ++*tlbHits;
 		break;
 	    }
 	if (entry == NULL) {				// not found
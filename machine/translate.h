@@ -21,6 +21,15 @@
 #include "copyright.h"
 #include "utility.h"
 
+// A page table is in two levels.  The directory is indexed by the high
+// bits of the virtual page number; each entry points to a "leaf" of
+// LeafSize translation entries, indexed by the low bits, or is NULL if
+// none of the leaf's pages are mapped.  So only the parts of an address
+// space that are in use need translation entries.
+
+#define LeafBits	5		// log2 of entries per leaf
+#define LeafSize	(1 << LeafBits)	// translation entries per leaf
+
 // The following class defines an entry in a translation table -- either
 // in a page table or a TLB.  Each entry defines a mapping from one 
 // virtual page to one physical page.
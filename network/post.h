@@ -68,8 +68,13 @@ class Mail {
      PacketHeader pktHdr;	// Header appended by Network
      MailHeader mailHdr;	// Header appended by PostOffice
      char data[MaxMailSize];	// Payload -- message data
+
+     ListLink<Mail> link;	// for the list of messages in a mailbox
 };
 
+// A list of messages waiting in a mailbox
+typedef SynchList<Mail, &Mail::link> MailList;
+
 // The following class defines a single mailbox, or temporary storage
 // for messages.   Incoming messages are put by the PostOffice into the 
 // appropriate mailbox, and these messages can then be retrieved by
@@ -87,7 +92,7 @@ class MailBox {
 				// mailbox (and wait if there is no message 
 				// to get!)
   private:
-    SynchList *messages;	// A mailbox is just a list of arrived messages
+    MailList *messages;		// A mailbox is just a list of arrived messages
 };
 
 // The following class defines a "Post Office", or a collection of 
@@ -0,0 +1,37 @@
+#!/bin/sh
+# bench.sh
+#	Compare the speed of the user program interpreters.
+#
+#	Runs each test program under each execution engine (nachos -e),
+#	and reports how many simulated instructions were run per second
+#	of host time.  Every user instruction takes one UserTick, so the
+#	"user" ticks Nachos prints at the end are the instruction count.
+#
+#	usage: bench.sh [program ...]
+
+NACHOS=${NACHOS:-../userprog/nachos}
+ENGINES=${ENGINES:-"interp batch threaded"}
+PROGRAMS=${*:-"matmult sort vectorsum"}
+
+now() {
+    date +%s.%N
+}
+
+printf "%-12s %-10s %12s %10s %14s\n" program engine instrs seconds instrs/sec
+for prog in $PROGRAMS; do
+    for engine in $ENGINES; do
+	start=`now`
+	out=`$NACHOS -e $engine -x $prog 2>&1`
+	end=`now`
+	instrs=`echo "$out" | sed -n 's/^Ticks:.* user \([0-9]*\).*/\1/p'`
+	if [ -z "$instrs" ]; then
+	    echo "$prog: nachos -e $engine did not finish" >&2
+	    continue
+	fi
+	echo "$start $end $instrs" | awk -v p=$prog -v e=$engine '{
+	    secs = $2 - $1;
+	    printf "%-12s %-10s %12d %10.3f %14.0f\n", p, e, $3, secs,
+		(secs > 0) ? $3 / secs : 0;
+	}'
+    done
+done
@@ -0,0 +1,30 @@
+/* consolewrite.c
+ *	Write to the console with one Write of many characters, and with
+ *	many PrintChars of one.  The kernel buffers both, so the display
+ *	should take far fewer write interrupts than characters (see the
+ *	"Console I/O" statistics when Nachos halts).
+ */
+
+#include "syscall.h"
+
+#define N	26
+
+char line[2 * N + 2];
+
+int
+main()
+{
+    int i;
+
+    for (i = 0; i < N; i++) {
+	line[i] = 'a' + i;
+	line[N + i] = 'A' + i;
+    }
+    line[2 * N] = '\n';
+    for (i = 0; i < 20; i++)
+	Write(line, 2 * N + 1, ConsoleOutput);
+    for (i = 0; i < 2 * N; i++)
+	PrintChar(line[i]);
+    PrintChar('\n');
+    return 0;
+}
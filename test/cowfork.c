@@ -0,0 +1,38 @@
+/* cowfork.c
+ *	Check that a forked child and its parent each see their own
+ *	writes, and only their own, after Fork shares their memory.
+ */
+
+#include "syscall.h"
+
+#define N	1024
+
+int shared[N];
+
+int
+main()
+{
+    int i, x, errors = 0;
+
+    for (i = 0; i < N; i++)
+	shared[i] = i;
+    x = Fork();
+    if (x == 0) {
+	for (i = 0; i < N; i++)
+	    shared[i] = -i;
+	for (i = 0; i < N; i++)
+	    if (shared[i] != -i)
+		errors++;
+	Exit(errors);
+    }
+    for (i = 0; i < N; i += 2)
+	shared[i] = 2 * i;
+    errors = Join(x);
+    for (i = 0; i < N; i++)
+	if (shared[i] != ((i % 2 == 0) ? 2 * i : i))
+	    errors++;
+    PrintString("Errors: ");
+    PrintInt(errors);
+    PrintChar('\n');
+    return 0;
+}
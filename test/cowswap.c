@@ -0,0 +1,52 @@
+/* cowswap.c
+ *	Fill memory with pages a parent and its forked children share
+ *	until one of them writes, and code they all run, so that those
+ *	shared frames must be sent out to swap for the rest to fit.
+ *	Only runs under VM.
+ */
+
+#include "syscall.h"
+
+#define N		3072	/* 12KB of ints; memory is 16KB */
+#define NumChildren	3
+
+int big[N];
+
+int
+check(int seed)
+{
+    int i, errors = 0;
+
+    for (i = 0; i < N; i++)		/* still shared with the parent */
+	if (big[i] != i)
+	    errors++;
+    for (i = 0; i < N; i++)		/* a copy of our own */
+	big[i] = i * seed;
+    for (i = 0; i < N; i++)
+	if (big[i] != i * seed)
+	    errors++;
+    return errors;
+}
+
+int
+main()
+{
+    int i, errors = 0, children[NumChildren];
+
+    for (i = 0; i < N; i++)
+	big[i] = i;
+    for (i = 0; i < NumChildren; i++) {
+	children[i] = Fork();
+	if (children[i] == 0)
+	    Exit(check(i + 2));
+    }
+    for (i = 0; i < NumChildren; i++)
+	errors += Join(children[i]);
+    for (i = 0; i < N; i++)
+	if (big[i] != i)
+	    errors++;
+    PrintString("Errors: ");
+    PrintInt(errors);
+    PrintChar('\n');
+    return 0;
+}
@@ -0,0 +1,37 @@
+/* forkexit.c
+ *	Fork and join many short-lived children, one after another.
+ *
+ *	Each child has an address space as big as ours, so this only
+ *	finishes if the frames of children that have exited are used
+ *	again.  A child can only be joined once.
+ */
+
+#include "syscall.h"
+
+#define NumChildren	5000
+
+int
+main()
+{
+    int i, x;
+
+    for (i = 0; i < NumChildren; i++) {
+	x = Fork();
+	if (x == 0)
+	    Exit(i);
+	if (Join(x) != i) {
+	    PrintString("Wrong exit status from child ");
+	    PrintInt(x);
+	    PrintChar('\n');
+	    Exit(1);
+	}
+	if (Join(x) != -1) {
+	    PrintString("Joined child twice ");
+	    PrintInt(x);
+	    PrintChar('\n');
+	    Exit(1);
+	}
+    }
+    PrintString("All children exited\n");
+    return 0;
+}
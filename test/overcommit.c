@@ -0,0 +1,44 @@
+/* overcommit.c
+ *	Use more memory than the machine has: a few processes, each
+ *	writing and then checking an array bigger than physical memory.
+ *	Only runs under VM, where pages are sent out to swap.
+ */
+
+#include "syscall.h"
+
+#define N		8192	/* 32KB of ints; memory is 16KB */
+#define NumChildren	3
+
+int big[N];
+
+int
+check(int seed)
+{
+    int i, errors = 0;
+
+    for (i = 0; i < N; i++)
+	big[i] = i * seed;
+    for (i = 0; i < N; i++)
+	if (big[i] != i * seed)
+	    errors++;
+    return errors;
+}
+
+int
+main()
+{
+    int i, errors = 0, children[NumChildren];
+
+    for (i = 0; i < NumChildren; i++) {
+	children[i] = Fork();
+	if (children[i] == 0)
+	    Exit(check(i + 2));
+    }
+    errors = check(1);
+    for (i = 0; i < NumChildren; i++)
+	errors += Join(children[i]);
+    PrintString("Errors: ");
+    PrintInt(errors);
+    PrintChar('\n');
+    return 0;
+}
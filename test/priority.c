@@ -0,0 +1,56 @@
+/* priority.c
+ *	Run two CPU-bound children next to one that mostly sleeps, and
+ *	print how late the sleeper runs each time it wakes up.  The hogs
+ *	use up their time slices and drop to low priorities, while the
+ *	sleeper stays at the top, so it should not wait long for them.
+ *	The second hog is also set to the lowest priority with
+ *	SetPriority.
+ */
+
+#include "syscall.h"
+
+#define Naps	5
+#define NapTime	1000
+
+int
+hog()
+{
+    int i, sum = 0;
+
+    for (i = 0; i < 100000; i++)
+	sum += i;
+    return sum;
+}
+
+int
+main()
+{
+    int pids[3], i, start;
+
+    pids[0] = Fork();
+    if (pids[0] == 0) {
+	hog();
+	Exit(0);
+    }
+    pids[1] = Fork();
+    if (pids[1] == 0) {
+	hog();
+	Exit(0);
+    }
+    SetPriority(pids[1], 7);
+    pids[2] = Fork();
+    if (pids[2] == 0) {
+	for (i = 0; i < Naps; i++) {
+	    start = GetTime();
+	    Sleep(NapTime);
+	    PrintString("Sleeper woke up late by ");
+	    PrintInt(GetTime() - start - NapTime);
+	    PrintString(" ticks\n");
+	}
+	Exit(0);
+    }
+    for (i = 0; i < 3; i++)
+	Join(pids[i]);
+    PrintString("All done.\n");
+    return 0;
+}
@@ -6,7 +6,7 @@ main()
     SpaceId newProc;
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
-    char prompt[2], ch, buffer[60];
+    char prompt[2], buffer[60];
     int i;
 
     prompt[0] = '-';
@@ -16,18 +16,21 @@ main()
     {
 	Write(prompt, 2, output);
 
-	i = 0;
-	
-	do {
-	
-	    Read(&buffer[i], 1, input); 
+	/* the console hands over a whole line at a time */
+	i = Read(buffer, sizeof(buffer) - 1, input);
+	if( i <= 0 )
+		Exit(0);
 
-	} while( buffer[i++] != '\n' );
-
-	buffer[--i] = '\0';
+	if( buffer[i - 1] == '\n' )
+		i--;
+	buffer[i] = '\0';
 
 	if( i > 0 ) {
-		newProc = Exec(buffer);
+		newProc = Fork();
+		if( newProc == 0 ) {
+			Exec(buffer);
+			Exit(-1);	/* no such program */
+		}
 		Join(newProc);
 	}
     }
@@ -202,6 +202,14 @@ GetTime:
 	j       $31
 	.end GetTime
 
+	.globl SetPriority
+	.ent    SetPriority
+SetPriority:
+	addiu $2,$0,SC_SetPriority
+	syscall
+	j       $31
+	.end SetPriority
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
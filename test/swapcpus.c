@@ -0,0 +1,49 @@
+/* swapcpus.c
+ *	Page to and from swap with several CPUs: two processes at once,
+ *	each writing an array bigger than physical memory, and checking
+ *	it.  Every page is written more than once, so that a page that
+ *	was sent out to swap, read back in, and written again must be
+ *	sent out again; if the write were lost, the check would read the
+ *	old contents back.
+ *
+ *	Only runs under VM.  Run it as "nachos -P 2 -x swapcpus", so that
+ *	each process has a CPU (and a TLB) of its own.
+ */
+
+#include "syscall.h"
+
+#define N		8192	/* 32KB of ints; memory is 16KB */
+#define Rounds		3
+
+int big[N];
+
+int
+check(int seed)
+{
+    int i, round, errors = 0;
+
+    for (round = 0; round < Rounds; round++) {
+	for (i = 0; i < N; i++)
+	    big[i] = i * seed + round;
+	for (i = 0; i < N; i++)
+	    if (big[i] != i * seed + round)
+		errors++;
+    }
+    return errors;
+}
+
+int
+main()
+{
+    int child, errors;
+
+    child = Fork();
+    if (child == 0)
+	Exit(check(2));
+    errors = check(1);
+    errors += Join(child);
+    PrintString("Errors: ");
+    PrintInt(errors);
+    PrintChar('\n');
+    return 0;
+}
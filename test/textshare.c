@@ -0,0 +1,25 @@
+/* textshare.c
+ *	Run many copies of the same program at once: each forked child
+ *	Execs vectorsum, whose code pages should all be loaded once and
+ *	shared.  Run with -d a to see the frames being shared.
+ */
+
+#include "syscall.h"
+
+#define N	8
+
+int
+main()
+{
+    int i, pids[N];
+
+    for (i = 0; i < N; i++) {
+	pids[i] = Fork();
+	if (pids[i] == 0)
+	    Exec("../test/vectorsum");
+    }
+    for (i = 0; i < N; i++)
+	Join(pids[i]);
+    PrintString("All copies done.\n");
+    return 0;
+}
@@ -0,0 +1,31 @@
+/* unmapped.c
+ *	Touch a page that is not mapped, but is in the same leaf of the
+ *	page table as pages that are: the stack is at the top of the
+ *	address space, and the rest of its leaf is not mapped.
+ *
+ *	Nachos should stop with an unexpected page fault exception
+ *	(PageFaultException is 2).  If the load goes through instead,
+ *	the page table handed the hardware a translation to some frame
+ *	the program does not own, and the value read is printed.
+ */
+
+#include "syscall.h"
+
+#define PageSize	128
+#define NumPages	32768	/* UserVirtPages */
+#define StackPages	8	/* UserStackSize / PageSize */
+#define LeafSize	32
+
+int
+main()
+{
+    int *p;
+
+    /* the first page of the stack's leaf; not part of the stack */
+    p = (int *) (((NumPages - StackPages) & ~(LeafSize - 1)) * PageSize);
+    PrintString("Touching an unmapped page\n");
+    PrintString("Read ");
+    PrintInt(*p);
+    PrintString(" from an unmapped page\n");
+    Halt();
+}
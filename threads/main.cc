@@ -8,23 +8,44 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sp <policy>
+//		-s -e <engine> -P <cpus> -q <ticks> -H -x <nachos file>
+//		-rp <policy> -tlb <entries> -tr <policy>
+//		-c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
-//              -z
+//              -z -ip <count> -lp <count>
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sp chooses how threads are scheduled: "mlfq" (multilevel feedback
+//	 queues, the default), "fifo", "fair" (by weighted CPU time) or
+//	 "stride"
 //    -z prints the copyright message
+//    -ip times scheduling <count> interrupts
+//    -lp times <count> list operations, List against TypedList and
+//	 SynchList
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -e selects how user programs are simulated: "interp" (the default),
+//	 "block" (translated basic blocks), "threaded" (threaded code) or
+//	 "batch" (interp, calling OneTick only when an interrupt is due)
+//    -P sets the number of simulated CPUs (default 1)
+//    -q runs each CPU for a quantum of this many ticks at a time
+//    -H runs those quanta on host threads, one per CPU, when it is safe
 //    -x runs a user program
 //    -c tests the console
 //
+//  VM
+//    -rp chooses which pages to evict when memory is full: "clock"
+//	 (second chance, the default) or "fifo"
+//    -tlb sets the number of entries in each CPU's TLB (default 4)
+//    -tr chooses which TLB entry a miss replaces: "random" (the
+//	 default) or "lru"
+//
 //  FILESYS
 //    -f causes the physical disk to be formatted
 //    -cp copies a file from UNIX to Nachos
@@ -59,7 +80,8 @@
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
-extern void MailTest(int networkID);
+extern void MailTest(int networkID), InterruptPerformance(int count);
+extern void ListPerformance(int count);
 
 //----------------------------------------------------------------------
 // main
@@ -92,6 +114,15 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+	else if (!strcmp(*argv, "-ip")) {	// time the interrupt queue
+	    ASSERT(argc > 1);
+	    InterruptPerformance(atoi(*(argv + 1)));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-lp")) {	// time the lists
+	    ASSERT(argc > 1);
+	    ListPerformance(atoi(*(argv + 1)));
+	    argCount = 2;
+	}
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
@@ -0,0 +1,340 @@
+// schedpolicy.cc
+//	Routines for the scheduling policies.  See schedpolicy.h.
+//
+//	These are called by the Scheduler with interrupts disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "schedpolicy.h"
+#include "system.h"
+#include <strings.h>
+
+#define BoostTicks	(100 * TimerTicks)	// how often every thread goes
+						// back to its base priority
+#define FairGranularity	TimerTicks		// how far ahead a thread gets
+						// before it gives up the CPU
+#define FairCredit	(2 * TimerTicks)	// how far behind a thread that
+						// was asleep may start
+
+//----------------------------------------------------------------------
+// TimeSlice
+// 	How long a thread may run at "priority" before it drops to the
+//	next one down.  Lower priorities run less often, but longer.
+//----------------------------------------------------------------------
+
+static int
+TimeSlice(int priority)
+{
+    return TimerTicks << priority;
+}
+
+//----------------------------------------------------------------------
+// Weighted
+// 	Scale "ticks" of CPU time by a thread's weight, for the fair and
+//	stride policies: each priority down has half the weight, so its
+//	time counts for twice as much.
+//----------------------------------------------------------------------
+
+static int
+Weighted(Thread *thread, int ticks)
+{
+    return ticks << thread->basePriority;
+}
+
+//----------------------------------------------------------------------
+// PrintThread
+// 	Print a thread on a ThreadList.
+//----------------------------------------------------------------------
+
+static void
+PrintThread(Thread *thread)
+{
+    thread->Print();
+}
+
+//----------------------------------------------------------------------
+// FIFOScheduling::ReadyToRun, FindNextToRun, Print
+// 	Threads run in the order they become ready.
+//----------------------------------------------------------------------
+
+void
+FIFOScheduling::ReadyToRun(Thread *thread)
+{
+    readyList.Append(thread);
+}
+
+Thread *
+FIFOScheduling::FindNextToRun()
+{
+    return readyList.Remove();
+}
+
+void
+FIFOScheduling::Print()
+{
+    readyList.Mapcar(PrintThread);
+    printf("\n");
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::FeedbackScheduling
+// 	Initialize the ready lists to empty.
+//----------------------------------------------------------------------
+
+FeedbackScheduling::FeedbackScheduling()
+{
+    readyLevels = 0;
+    nextBoost = BoostTicks;
+    lastBoost = -1;
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::ReadyToRun
+// 	Put a thread on the ready list for its priority.  A thread that
+//	was asleep goes back to its base priority, with a fresh time
+//	slice.
+//----------------------------------------------------------------------
+
+void
+FeedbackScheduling::ReadyToRun(Thread *thread)
+{
+    if (thread->getStatus() == BLOCKED) {
+	thread->priority = thread->basePriority;
+	thread->ticksUsed = 0;
+    }
+    readyList[thread->priority].Append(thread);
+    readyLevels |= 1 << thread->priority;
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::FindNextToRun
+// 	Take the first thread off the highest priority list that is not
+//	empty.
+//----------------------------------------------------------------------
+
+Thread *
+FeedbackScheduling::FindNextToRun()
+{
+    Thread *thread;
+    int level;
+
+    if (readyLevels == 0)
+	return NULL;
+    level = ffs(readyLevels) - 1;
+    thread = readyList[level].Remove();
+    if (readyList[level].IsEmpty())
+	readyLevels &= ~(1 << level);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::Tick
+// 	Charge the running thread; if that uses up its time slice, it
+//	drops a priority.  It should yield if a thread with a higher
+//	priority is ready, or if its time slice is up and one with the
+//	same priority is.
+//----------------------------------------------------------------------
+
+bool
+FeedbackScheduling::Tick(Thread *thread, int elapsed)
+{
+    if (stats->totalTicks >= nextBoost) {
+	Boost(thread);
+	lastBoost = stats->totalTicks;
+	nextBoost = stats->totalTicks + BoostTicks;
+    } else if (stats->totalTicks == lastBoost) {	// on another CPU
+	thread->priority = thread->basePriority;
+	thread->ticksUsed = 0;
+    }
+
+    thread->ticksUsed += elapsed;
+    if (thread->ticksUsed >= TimeSlice(thread->priority)) {
+	if (thread->priority < NumPriorities - 1)
+	    thread->priority++;
+	thread->ticksUsed = 0;
+	DEBUG('t', "Thread \"%s\" used its time slice, now priority %d\n",
+					thread->getName(), thread->priority);
+	return (readyLevels & ((2 << thread->priority) - 1)) != 0;
+    }
+    return (readyLevels & ((1 << thread->priority) - 1)) != 0;
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::SetPriority
+// 	A thread that is not on a ready list goes to its new base
+//	priority straight away; one that is gets it the next time it is
+//	put on one.
+//----------------------------------------------------------------------
+
+void
+FeedbackScheduling::SetPriority(Thread *thread, int priority)
+{
+    thread->basePriority = priority;
+    if (thread->getStatus() != READY) {
+	thread->priority = priority;
+	thread->ticksUsed = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// FeedbackScheduling::Boost
+// 	Put every ready thread, and the running one, back at its base
+//	priority with a fresh time slice, so that threads that have
+//	dropped to the bottom are not starved by a stream of ones above.
+//	Ready threads keep their order, priority by priority.
+//----------------------------------------------------------------------
+
+void
+FeedbackScheduling::Boost(Thread *running)
+{
+    ThreadList ready;
+    Thread *thread;
+
+    DEBUG('t', "Boosting every thread to its base priority\n");
+    while ((thread = FindNextToRun()) != NULL)
+	ready.Append(thread);
+    while ((thread = ready.Remove()) != NULL) {
+	thread->priority = thread->basePriority;
+	thread->ticksUsed = 0;
+	ReadyToRun(thread);
+    }
+
+    running->priority = running->basePriority;
+    running->ticksUsed = 0;
+}
+
+void
+FeedbackScheduling::Print()
+{
+    for (int i = 0; i < NumPriorities; i++)
+	if (!readyList[i].IsEmpty()) {
+	    printf("  priority %d: ", i);
+	    readyList[i].Mapcar(PrintThread);
+	    printf("\n");
+	}
+}
+
+//----------------------------------------------------------------------
+// VirtualTimeScheduling::Enqueue
+// 	Put a thread in the tree, by its virtual time.  A thread that is
+//	new, or was asleep, has fallen behind; it catches up to "credit"
+//	behind the least virtual time of the others, so that it cannot
+//	make up all the time it was away.
+//----------------------------------------------------------------------
+
+void
+VirtualTimeScheduling::Enqueue(Thread *thread, int credit)
+{
+    if ((thread->getStatus() != RUNNING) &&
+			(thread->virtualTime < minVirtualTime - credit))
+	thread->virtualTime = minVirtualTime - credit;
+    tree->SortedInsert((void *)thread, thread->virtualTime);
+}
+
+//----------------------------------------------------------------------
+// VirtualTimeScheduling::Advance
+// 	Keep minVirtualTime up with the threads: the least virtual time
+//	of the running thread and the ready ones.  Otherwise, while a
+//	thread runs alone, it would stay where the last thread to come
+//	out of the tree left it, and a thread that woke up then would
+//	start far behind, and keep the CPU until it caught up.
+//----------------------------------------------------------------------
+
+void
+VirtualTimeScheduling::Advance(Thread *running)
+{
+    int least = running->virtualTime;
+
+    if (!tree->IsEmpty() && (tree->MinKey() < least))
+	least = tree->MinKey();
+    if (least > minVirtualTime)
+	minVirtualTime = least;
+}
+
+//----------------------------------------------------------------------
+// VirtualTimeScheduling::FindNextToRun
+// 	Take the thread with the least virtual time out of the tree.
+//----------------------------------------------------------------------
+
+Thread *
+VirtualTimeScheduling::FindNextToRun()
+{
+    Thread *thread;
+    int key;
+
+    thread = (Thread *)tree->SortedRemove(&key);
+    if ((thread != NULL) && (key > minVirtualTime))
+	minVirtualTime = key;
+    return thread;
+}
+
+void
+VirtualTimeScheduling::Print()
+{
+    tree->Mapcar((VoidFunctionPtr) ThreadPrint);
+    printf("\n");
+}
+
+//----------------------------------------------------------------------
+// FairScheduling::ReadyToRun, Tick
+// 	A thread is charged for the time it uses, weighted, and gives
+//	up the CPU once it is FairGranularity ahead of the thread that
+//	has had the least.
+//----------------------------------------------------------------------
+
+void
+FairScheduling::ReadyToRun(Thread *thread)
+{
+    Enqueue(thread, FairCredit);
+}
+
+bool
+FairScheduling::Tick(Thread *thread, int elapsed)
+{
+    thread->virtualTime += Weighted(thread, elapsed);
+    Advance(thread);
+    return !tree->IsEmpty() &&
+		(thread->virtualTime - tree->MinKey() >= FairGranularity);
+}
+
+//----------------------------------------------------------------------
+// StrideScheduling::ReadyToRun, FindNextToRun, Tick
+// 	A thread is charged its stride for a time slice when it is
+//	given one.  At the end of each slice, it gives up the CPU if
+//	some thread has had no more; otherwise it is given another.
+//----------------------------------------------------------------------
+
+void
+StrideScheduling::ReadyToRun(Thread *thread)
+{
+    Enqueue(thread, 0);
+}
+
+Thread *
+StrideScheduling::FindNextToRun()
+{
+    Thread *thread = VirtualTimeScheduling::FindNextToRun();
+
+    if (thread != NULL) {
+	thread->virtualTime += Weighted(thread, TimerTicks);
+	thread->ticksUsed = 0;
+    }
+    return thread;
+}
+
+bool
+StrideScheduling::Tick(Thread *thread, int elapsed)
+{
+    thread->ticksUsed += elapsed;
+    if (thread->ticksUsed < TimerTicks)
+	return FALSE;
+    thread->ticksUsed = 0;
+    if (!tree->IsEmpty() && (tree->MinKey() <= thread->virtualTime))
+	return TRUE;
+    thread->virtualTime += Weighted(thread, TimerTicks);
+    Advance(thread);
+    return FALSE;
+}
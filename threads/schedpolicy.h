@@ -0,0 +1,149 @@
+// schedpolicy.h
+//	Data structures for the scheduling policies: how the scheduler
+//	keeps the threads that are ready to run, which one runs next,
+//	and when the running thread has had its turn.
+//
+//	The Scheduler does the dispatching, and calls the policy with
+//	interrupts disabled.  Each kind of policy is a subclass:
+//
+//	FIFO -- one ready list, no time slicing; a thread runs until it
+//		sleeps or yields.
+//	multilevel feedback queues -- see FeedbackScheduling.
+//	fair -- threads share the CPU in proportion to their weights,
+//		by running the one with the least weighted CPU time.
+//	stride -- threads get time slices in proportion to their
+//		tickets, in a fixed pattern.
+//
+//	Every policy takes a thread's base priority (see SetPriority)
+//	into account: as its level for the feedback queues, and to
+//	weight its share of the CPU for the fair and stride policies.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDPOLICY_H
+#define SCHEDPOLICY_H
+
+#include "copyright.h"
+#include "sortedtree.h"
+#include "thread.h"
+
+#define NumPriorities	8	// base priorities; 0 is the highest
+
+// The following class defines a scheduling policy.
+
+class SchedulingPolicy {
+  public:
+    virtual ~SchedulingPolicy() {}
+
+    virtual void ReadyToRun(Thread *thread) = 0;
+				// Put "thread" with the ready threads;
+				// its status says whether it was just
+				// created, asleep, or running
+    virtual Thread *FindNextToRun() = 0;
+				// Take the next thread to run away from
+				// the ready threads; NULL if there are none
+    virtual bool Tick(Thread *thread, int elapsed) { return FALSE; }
+				// "thread" has run "elapsed" more ticks;
+				// TRUE if it should give up the CPU
+    virtual void SetPriority(Thread *thread, int priority)
+	{ thread->basePriority = priority; }
+				// Change the base priority of "thread"
+    virtual void Print() = 0;	// Print the ready threads
+};
+
+// First come, first served.
+
+class FIFOScheduling : public SchedulingPolicy {
+  public:
+    void ReadyToRun(Thread *thread);
+    Thread *FindNextToRun();
+    void Print();
+
+  private:
+    ThreadList readyList;	// threads ready to run, in order
+};
+
+// Multilevel feedback queues: one FIFO list per priority, and a
+// bitmap of the lists that are not empty, so the next thread is found
+// in constant time.  A thread that uses up the time slice for its
+// priority drops to the next one down, where the slice is twice as
+// long; one that sleeps (for I/O, say) goes back to its base priority
+// when it wakes up.  Every so often, every thread goes back to its base
+// priority, so that none starves.
+
+class FeedbackScheduling : public SchedulingPolicy {
+  public:
+    FeedbackScheduling();
+    void ReadyToRun(Thread *thread);
+    Thread *FindNextToRun();
+    bool Tick(Thread *thread, int elapsed);
+    void SetPriority(Thread *thread, int priority);
+    void Print();
+
+  private:
+    void Boost(Thread *running);	// Put every thread back at its
+					// base priority
+
+    ThreadList readyList[NumPriorities];	// threads ready at each priority
+    unsigned int readyLevels;	// bit i is set if readyList[i] is not
+				// empty
+    int nextBoost;		// when every thread next goes back to
+				// its base priority
+    int lastBoost;		// when they last did, so that the
+				// threads on other CPUs, charged for
+				// the same tick, go back too
+};
+
+// Threads kept in a balanced tree by their "virtual time": the CPU
+// time they have used, scaled by their weight.  The one that has had
+// the least runs next.  A thread that was asleep, or is new, starts
+// near the least virtual time of the others, so that it gets no more
+// than its share for having been away.
+
+class VirtualTimeScheduling : public SchedulingPolicy {
+  public:
+    VirtualTimeScheduling() { tree = new SortedTree; minVirtualTime = 0; }
+    ~VirtualTimeScheduling() { delete tree; }
+    Thread *FindNextToRun();
+    void Print();
+
+  protected:
+    void Enqueue(Thread *thread, int credit);
+				// Put "thread" in the tree; if it has been
+				// away, let it start up to "credit" ahead
+				// of the others
+    void Advance(Thread *running);
+				// Bring minVirtualTime up to the least
+				// virtual time of "running" and the tree
+
+    SortedTree *tree;		// the ready threads, by virtual time
+    int minVirtualTime;		// the least virtual time of the running
+				// and ready threads, as of the last
+				// tick; it never goes down
+};
+
+// Completely fair: the running thread is charged for the time it
+// actually uses, and gives up the CPU once it is far enough ahead of
+// the thread that has had the least.
+
+class FairScheduling : public VirtualTimeScheduling {
+  public:
+    void ReadyToRun(Thread *thread);
+    bool Tick(Thread *thread, int elapsed);
+};
+
+// Stride scheduling: a thread is charged its "stride", the inverse of
+// its tickets, for each whole time slice it is given, used or not;
+// at the end of each slice, the thread with the least virtual time
+// (its "pass") runs next.
+
+class StrideScheduling : public VirtualTimeScheduling {
+  public:
+    void ReadyToRun(Thread *thread);
+    Thread *FindNextToRun();
+    bool Tick(Thread *thread, int elapsed);
+};
+
+#endif // SCHEDPOLICY_H
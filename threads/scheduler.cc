@@ -4,15 +4,16 @@
 //
 // 	These routines assume that interrupts are already disabled.
 //	If interrupts are disabled, we can assume mutual exclusion
-//	(since we are on a uniprocessor).
+//	(even with several simulated CPUs, since we only switch between
+//	them while running user code).
 //
 // 	NOTE: We can't use Locks to provide mutual exclusion here, since
 // 	if we needed to wait for a lock, and the lock was busy, we would 
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+//	Which thread runs next is up to the scheduling policy: see
+//	schedpolicy.h.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -24,28 +25,46 @@
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
-// 	Initialize the list of ready but not running threads to empty.
+// 	Initialize the scheduler, with no threads ready to run.
+//	Whatever thread is running when we are first asked to switch
+//	CPUs is taken to be on CPU 0; the other CPUs start idle.
+//
+//	"howMany" -- the number of simulated CPUs
+//	"how" -- the scheduling policy; it is ours to de-allocate
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(int howMany, SchedulingPolicy *how)
 { 
-    readyList = new List; 
+    ASSERT(howMany > 0);
+    policy = how;
+    lastTick = 0;
+    numCPUs = howMany;
+    cpu = 0;
+    cpus = new CPUState[numCPUs];
+    for (int i = 0; i < numCPUs; i++) {
+	cpus[i].thread = NULL;
+	cpus[i].yieldPending = FALSE;
+#ifdef USER_PROGRAM
+	cpus[i].space = NULL;
+#endif
+    }
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the scheduler and its policy.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
+    delete policy; 
+    delete [] cpus;
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::ReadyToRun
 // 	Mark a thread as ready, but not running.
-//	Put it on the ready list, for later scheduling onto the CPU.
+//	Give it to the policy, for later scheduling onto the CPU.
 //
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
@@ -55,14 +74,24 @@ Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
     
+    policy->ReadyToRun(thread);
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    thread->readySince = stats->totalTicks;
+
+    // If we were idle, the timer may have been told to skip its
+    // interrupts until the next sleeper is due; the new thread needs
+    // them for time-slicing, and should not be charged for the time
+    // nobody ran.
+    if ((timer != NULL) && timer->Resume())
+	lastTick = stats->totalTicks;
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
+// 	Return the next thread to be scheduled onto the CPU, as the
+//	policy chooses.  If there are no ready threads, return NULL.
+//	Whoever calls this runs the thread, so here is where we count
+//	how long it waited.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -70,7 +99,60 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+    Thread *thread = policy->FindNextToRun();
+
+    if (thread != NULL)
+	stats->NoteReadyWait(stats->totalTicks - thread->readySince);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Tick
+// 	Called by the timer interrupt handler.  Charge the current thread
+//	for the time since the last timer interrupt, and return TRUE if
+//	the policy says it has had its turn.
+//
+//	With more than one CPU, the threads on the other busy CPUs ran
+//	for that time too, and are charged as well.  The timer only
+//	interrupts the current CPU, so one that has had its turn yields
+//	when its CPU next runs (see YieldIfDue).
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Tick()
+{
+    int elapsed = stats->totalTicks - lastTick;
+    Thread *thread;
+
+    lastTick = stats->totalTicks;
+    for (int i = 0; i < numCPUs; i++) {
+	thread = cpus[i].thread;
+	if ((i != cpu) && (thread != NULL) && 
+				(thread->getStatus() == RUNNING) &&
+				policy->Tick(thread, elapsed))
+	    cpus[i].yieldPending = TRUE;
+    }
+    if (currentThread->getStatus() != RUNNING)		// idle
+	return FALSE;
+    return policy->Tick(currentThread, elapsed);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetPriority
+// 	Change the base priority of "thread"; what that does is up to
+//	the policy.
+//
+//	"priority" -- the new base priority, 0 (highest) to
+//		NumPriorities - 1
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetPriority(Thread *thread, int priority)
+{
+    ASSERT((priority >= 0) && (priority < NumPriorities));
+    DEBUG('t', "Thread \"%s\" now has base priority %d\n",
+					thread->getName(), priority);
+    policy->SetPriority(thread, priority);
 }
 
 //----------------------------------------------------------------------
@@ -81,6 +163,9 @@ Scheduler::FindNextToRun ()
 //
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
+//
+//	The old thread's address space is saved only if the new thread
+//	has a different one; otherwise the CPU can go on using its TLB.
 // Side effect:
 //	The global variable currentThread becomes nextThread.
 //
@@ -90,20 +175,38 @@ Scheduler::FindNextToRun ()
 void
 Scheduler::Run (Thread *nextThread)
 {
-    Thread *oldThread = currentThread;
-    
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
+	if (nextThread->space != currentThread->space) {
+	    currentThread->space->SaveState();
+	    cpus[cpu].space = NULL;
+	}
     }
 #endif
+    cpus[cpu].yieldPending = FALSE;	// the thread is going anyway
+    Dispatch(nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	The rest of Run: switch to nextThread, once the old thread's user
+//	state, if any, has been saved.  SwitchCPU saves just the registers
+//	itself, since each CPU keeps its own TLB.
+//
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch (Thread *nextThread)
+{
+    Thread *oldThread = currentThread;
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    cpus[cpu].thread = nextThread;	    // on this CPU
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
@@ -132,19 +235,200 @@ Scheduler::Run (Thread *nextThread)
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
         currentThread->RestoreUserState();     // to restore, do it.
+	LoadSpace();
+    }
+#endif
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// Scheduler::LoadSpace
+// 	Get the current CPU ready to run currentThread's user program,
+//	whenever the thread starts or resumes running.  The CPU's TLB (or
+//	page table register) is reloaded only if it was last loaded for
+//	some other address space.
+//----------------------------------------------------------------------
+
+void
+Scheduler::LoadSpace()
+{
+    if (cpus[cpu].space != currentThread->space) {
 	currentThread->space->RestoreState();
+	cpus[cpu].space = currentThread->space;
     }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ForgetSpace
+// 	Called when an address space is de-allocated, so that no CPU
+//	takes a new one, which may be at the same address, to be loaded
+//	already.
+//
+//	"space" -- the address space going away
+//----------------------------------------------------------------------
+
+void
+Scheduler::ForgetSpace(AddrSpace *space)
+{
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i].space == space)
+	    cpus[i].space = NULL;
+}
+#endif
+
+//----------------------------------------------------------------------
+// Scheduler::LastInRound
+// 	Return TRUE if no CPU after the current one has a thread to run,
+//	so that once the current CPU has run an instruction, every busy
+//	CPU has had its turn, and simulated time should advance.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::LastInRound()
+{
+    for (int i = cpu + 1; i < numCPUs; i++)
+	if (cpus[i].thread != NULL)
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextCPU
+// 	End the current CPU's turn.  Called by the machine simulation,
+//	between two user instructions.
+//
+//	First, give any idle CPU a thread from the ready list.  A thread
+//	comes off the ready list in the kernel, with interrupts disabled,
+//	as it would if the CPU had found it there itself.  Then switch
+//	to the next CPU that has a thread, if there is one besides this.
+//----------------------------------------------------------------------
+
+void
+Scheduler::NextCPU()
+{
+    Thread *thread;
+    int next;
+
+    cpus[cpu].thread = currentThread;
+    for (int i = 0; i < numCPUs; i++)
+	if ((cpus[i].thread == NULL) && 
+			((thread = FindNextToRun()) != NULL)) {
+	    DEBUG('t', "Dispatching thread \"%s\" onto CPU %d\n",
+						thread->getName(), i);
+	    cpus[i].thread = thread;
+	    cpus[i].level = IntOff;
+	    cpus[i].status = SystemMode;
+	    cpus[i].yieldPending = FALSE;
+	}
+
+    next = cpu;
+    do {
+	next = (next + 1) % numCPUs;
+    } while (cpus[next].thread == NULL);
+    if (next != cpu)
+	SwitchCPU(next);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::YieldIfDue
+// 	Called by the machine simulation when the current thread gets its
+//	turn, once its registers are in the machine.  If the timer said
+//	the thread should yield while its CPU was waiting, it does so now,
+//	as though the interrupt had just come.
+//----------------------------------------------------------------------
+
+void
+Scheduler::YieldIfDue()
+{
+    MachineStatus old;
+
+    if (!cpus[cpu].yieldPending)
+	return;
+    cpus[cpu].yieldPending = FALSE;
+    old = interrupt->getStatus();
+    interrupt->setStatus(SystemMode);	// yield is a kernel routine
+    currentThread->Yield();
+    interrupt->setStatus(old);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IdleCPU
+// 	Called by Thread::Sleep when there is nothing on the ready list.
+//	If some other CPU is running a thread, the current CPU becomes
+//	idle, and we switch to that CPU; the sleeping thread continues
+//	once someone has woken it up and a CPU has picked it up.
+//
+//	Returns FALSE, without doing anything, if no other CPU is busy;
+//	then there is really nothing to run.
+//
+//	The sleeping thread may be picked up by another CPU, so the idle
+//	one must not keep its address space loaded.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IdleCPU()
+{
+    int next;
+
+    for (next = (cpu + 1) % numCPUs; next != cpu; next = (next + 1) % numCPUs)
+	if (cpus[next].thread != NULL)
+	    break;
+    if (next == cpu)
+	return FALSE;
+
+    DEBUG('t', "CPU %d is idle\n", cpu);
+    cpus[cpu].thread = NULL;
+#ifdef USER_PROGRAM
+    if (currentThread->space != NULL) {
+	currentThread->space->SaveState();
+	cpus[cpu].space = NULL;
+    }
+#endif
+    SwitchCPU(next);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCPU
+// 	Make "which" the CPU being simulated.  The interrupt level and
+//	the kernel/user mode belong to the CPU, so we save the current
+//	CPU's and load the new one's, without letting time advance.  Then
+//	we switch to the thread on the new CPU, which picks up where it
+//	left off.  Returns when some CPU switches back to this thread.
+//
+//	Only the old thread's registers are saved.  Each CPU keeps its
+//	own TLB, so the old CPU's stays loaded for when its thread next
+//	gets a turn, and the new CPU's is still good for the thread on
+//	it; neither has to be flushed.
+//
+//	"which" -- the CPU to switch to; it must have a thread
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCPU(int which)
+{
+    ASSERT(cpus[which].thread != NULL);
+    cpus[cpu].level = interrupt->getLevel();
+    cpus[cpu].status = interrupt->getStatus();
+    cpu = which;
+#ifdef USER_PROGRAM
+    if (currentThread->space != NULL)
+        currentThread->SaveUserState();
+    machine->SelectCPU(cpu);
 #endif
+    interrupt->ChangeLevel(interrupt->getLevel(), cpus[cpu].level);
+    interrupt->setStatus(cpus[cpu].status);
+    Dispatch(cpus[cpu].thread);
 }
 
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
-//	the ready list.  For debugging.
+//	the ready lists.  For debugging.
 //----------------------------------------------------------------------
 void
 Scheduler::Print()
 {
     printf("Ready list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    policy->Print();
 }
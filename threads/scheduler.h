@@ -10,27 +10,92 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
-#include "list.h"
+#include "schedpolicy.h"
 #include "thread.h"
+#include "interrupt.h"
+// The following class defines what the scheduler keeps for each
+// simulated CPU: the thread running on it, the interrupt level and
+// machine status that CPU had when we last switched away from it,
+// whether its thread is to yield when the CPU next gets its turn, and
+// which address space its TLB (or page table register) is loaded for.
+
+class CPUState {
+  public:
+    Thread *thread;		// NULL if the CPU is idle
+    IntStatus level;		// interrupts enabled on this CPU?
+    MachineStatus status;	// kernel or user mode on this CPU
+    bool yieldPending;		// the timer said the thread should
+				// yield, while the CPU awaited its turn
+#ifdef USER_PROGRAM
+    AddrSpace *space;		// NULL if nothing is loaded
+#endif
+};
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// There can be more than one simulated CPU.  They all run on the one
+// host thread, taking turns one user instruction at a time: each turn
+// ends with a switch to the thread on the next busy CPU.  Simulated
+// time advances by one tick per round, i.e. once every busy CPU has
+// had its turn, so that threads on different CPUs run in parallel.
+// Kernel code is never interrupted by a switch of CPUs, as though
+// there were one lock around the whole kernel.
+//
+// How the ready threads are kept, and which runs next, is up to a
+// SchedulingPolicy.
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
-    ~Scheduler();			// De-allocate ready list
+    Scheduler(int cpus, SchedulingPolicy *how);
+					// Initialize, for "cpus" simulated
+					// CPUs, with no threads ready
+    ~Scheduler();			// De-allocate, and the policy too
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+    bool Tick();			// Charge the thread on every busy CPU
+					// for the time since the last timer
+					// interrupt; TRUE if the current one
+					// should yield
+    void SetPriority(Thread *thread, int priority);
+					// Change a thread's base priority
+
+    int NumCPUs() { return numCPUs; }
+    int CurrentCPU() { return cpu; }	// which CPU currentThread is on
+    bool LastInRound();			// Is the current CPU the last busy
+					// one to take its turn this tick?
+    void NextCPU();			// End this CPU's turn: put ready
+					// threads on idle CPUs, and switch
+					// to the next busy CPU
+    void YieldIfDue();			// Yield, if the timer said to while
+					// the current CPU awaited its turn
+    bool IdleCPU();			// Leave the current CPU idle and
+					// switch to another busy CPU, if any
+#ifdef USER_PROGRAM
+    void LoadSpace();			// Get the current CPU ready to run
+					// currentThread's user program
+    void ForgetSpace(AddrSpace *space);	// "space" is going away; no CPU
+					// has it loaded any more
+#endif
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+    SchedulingPolicy *policy;	// keeps the threads that are ready to
+				// run, but not running
+    int lastTick;		// when Tick last charged a thread
+    int numCPUs;		// number of simulated CPUs
+    int cpu;			// the CPU being simulated right now
+    CPUState *cpus;		// the state of each CPU
+
+    void SwitchCPU(int which);	// Make "which" the current CPU, and
+				// switch to the thread running on it
+    void Dispatch(Thread *nextThread);
+				// Run(), once the old thread's state
+				// has been saved
 };
 
 #endif // SCHEDULER_H
@@ -0,0 +1,250 @@
+// sortedtree.cc
+//	Routines to manage a balanced binary tree of items sorted by key.
+//	See sortedtree.h.
+//
+//	The routines that change the tree work recursively, each
+//	returning the new root of the subtree it was given; the tree is
+//	only ever O(log n) deep, so the recursion is too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "sortedtree.h"
+
+//----------------------------------------------------------------------
+// Height, Fix, Before
+// 	The height of a subtree (0 if it is empty); recompute a node's
+//	height from its subtrees; and whether node "a" is sorted before
+//	node "b".
+//----------------------------------------------------------------------
+
+static int
+Height(TreeNode *tree)
+{
+    return (tree == NULL) ? 0 : tree->height;
+}
+
+static void
+Fix(TreeNode *tree)
+{
+    tree->height = 1 + max(Height(tree->left), Height(tree->right));
+}
+
+static bool
+Before(TreeNode *a, TreeNode *b)
+{
+    return (a->key < b->key) ||
+	((a->key == b->key) && ((int) (a->order - b->order) < 0));
+}
+
+//----------------------------------------------------------------------
+// RotateLeft, RotateRight
+// 	Make a node's right (or left) child the root of its subtree,
+//	keeping the order.  Returns the new root.
+//----------------------------------------------------------------------
+
+static TreeNode *
+RotateLeft(TreeNode *tree)
+{
+    TreeNode *root = tree->right;
+
+    tree->right = root->left;
+    root->left = tree;
+    Fix(tree);
+    Fix(root);
+    return root;
+}
+
+static TreeNode *
+RotateRight(TreeNode *tree)
+{
+    TreeNode *root = tree->left;
+
+    tree->left = root->right;
+    root->right = tree;
+    Fix(tree);
+    Fix(root);
+    return root;
+}
+
+//----------------------------------------------------------------------
+// SortedTree::SortedTree
+// 	Initialize an empty tree.
+//----------------------------------------------------------------------
+
+SortedTree::SortedTree()
+{
+    root = NULL;
+    nextOrder = 0;
+    freeNodes = NULL;
+}
+
+//----------------------------------------------------------------------
+// SortedTree::~SortedTree
+// 	De-allocate the tree's nodes.  The items in it are not ours to
+//	de-allocate.
+//----------------------------------------------------------------------
+
+SortedTree::~SortedTree()
+{
+    TreeNode *node;
+
+    while (!IsEmpty())
+	(void) SortedRemove(NULL);
+    while (freeNodes != NULL) {
+	node = freeNodes;
+	freeNodes = node->right;
+	delete node;
+    }
+}
+
+//----------------------------------------------------------------------
+// SortedTree::SortedInsert
+// 	Put an item in the tree, sorted by "sortKey".  Items with the same
+//	key are taken out in the order they were put in.
+//
+//	"item" -- the thing to put in the tree
+//	"sortKey" -- what to sort it by
+//----------------------------------------------------------------------
+
+void
+SortedTree::SortedInsert(void *item, int sortKey)
+{
+    TreeNode *node = freeNodes;
+
+    if (node != NULL)
+	freeNodes = node->right;
+    else
+	node = new TreeNode;
+    node->item = item;
+    node->key = sortKey;
+    node->order = nextOrder++;
+    node->height = 1;
+    node->left = node->right = NULL;
+    root = Insert(root, node);
+}
+
+//----------------------------------------------------------------------
+// SortedTree::SortedRemove
+// 	Take the item with the smallest key out of the tree, and return
+//	it.  Returns NULL if the tree is empty.
+//
+//	"keyPtr" -- if not NULL, where to put the item's key
+//----------------------------------------------------------------------
+
+void *
+SortedTree::SortedRemove(int *keyPtr)
+{
+    TreeNode *node;
+
+    if (root == NULL)
+	return NULL;
+    root = RemoveMin(root, &node);
+    if (keyPtr != NULL)
+	*keyPtr = node->key;
+    node->right = freeNodes;
+    freeNodes = node;
+    return node->item;
+}
+
+//----------------------------------------------------------------------
+// SortedTree::MinKey
+// 	Return the smallest key in the tree, which must not be empty.
+//----------------------------------------------------------------------
+
+int
+SortedTree::MinKey()
+{
+    TreeNode *node = root;
+
+    ASSERT(node != NULL);
+    while (node->left != NULL)
+	node = node->left;
+    return node->key;
+}
+
+//----------------------------------------------------------------------
+// SortedTree::Mapcar
+// 	Apply a function to each item in the tree, in order.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+void
+SortedTree::Mapcar(VoidFunctionPtr func)
+{
+    Walk(root, func);
+}
+
+void
+SortedTree::Walk(TreeNode *tree, VoidFunctionPtr func)
+{
+    if (tree == NULL)
+	return;
+    Walk(tree->left, func);
+    (*func)((int) tree->item);
+    Walk(tree->right, func);
+}
+
+//----------------------------------------------------------------------
+// SortedTree::Insert
+// 	Put "node" in the subtree "tree", and return the subtree's new
+//	root, balanced again.
+//----------------------------------------------------------------------
+
+TreeNode *
+SortedTree::Insert(TreeNode *tree, TreeNode *node)
+{
+    if (tree == NULL)
+	return node;
+    if (Before(node, tree))
+	tree->left = Insert(tree->left, node);
+    else
+	tree->right = Insert(tree->right, node);
+    return Rebalance(tree);
+}
+
+//----------------------------------------------------------------------
+// SortedTree::RemoveMin
+// 	Take the first node out of the subtree "tree", putting it in
+//	*minPtr, and return the subtree's new root, balanced again.
+//----------------------------------------------------------------------
+
+TreeNode *
+SortedTree::RemoveMin(TreeNode *tree, TreeNode **minPtr)
+{
+    if (tree->left == NULL) {
+	*minPtr = tree;
+	return tree->right;
+    }
+    tree->left = RemoveMin(tree->left, minPtr);
+    return Rebalance(tree);
+}
+
+//----------------------------------------------------------------------
+// SortedTree::Rebalance
+// 	The subtrees of "tree" are balanced, but their heights may now
+//	differ by two; if so, rotate to bring them back within one.
+//	Returns the subtree's new root.
+//----------------------------------------------------------------------
+
+TreeNode *
+SortedTree::Rebalance(TreeNode *tree)
+{
+    int balance = Height(tree->left) - Height(tree->right);
+
+    if (balance > 1) {
+	if (Height(tree->left->left) < Height(tree->left->right))
+	    tree->left = RotateLeft(tree->left);
+	return RotateRight(tree);
+    }
+    if (balance < -1) {
+	if (Height(tree->right->right) < Height(tree->right->left))
+	    tree->right = RotateRight(tree->right);
+	return RotateLeft(tree);
+    }
+    Fix(tree);
+    return tree;
+}
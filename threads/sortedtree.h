@@ -0,0 +1,70 @@
+// sortedtree.h
+//	Data structures for a balanced binary tree of items sorted by
+//	key, for queues that are always taken from the smallest key
+//	(e.g., threads sorted by how much CPU time they have had).
+//
+//	The tree is an AVL tree: the heights of the two subtrees of
+//	every node differ by at most one, so putting an item in or
+//	taking the smallest out takes time logarithmic in the number of
+//	items, where List::SortedInsert walks the list.  Items with the
+//	same key come out in the order they went in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SORTEDTREE_H
+#define SORTEDTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines one node of the tree, holding one item.
+
+class TreeNode {
+  public:
+    void *item;			// the item in the tree
+    int key;			// what it is sorted by
+    unsigned int order;		// when it was put in, relative to others
+				// with the same key
+    int height;			// of the subtree this node is the root of
+    TreeNode *left;		// items that come before this one
+    TreeNode *right;		// items that come after it
+};
+
+// The following class defines the tree.
+
+class SortedTree {
+  public:
+    SortedTree();		// initialize an empty tree
+    ~SortedTree();		// de-allocate the tree
+
+    void SortedInsert(void *item, int sortKey);
+				// Put "item" in the tree, by "sortKey"
+    void *SortedRemove(int *keyPtr);
+				// Take out the item with the smallest key,
+				// and return it (its key in *keyPtr, if
+				// not NULL); NULL if the tree is empty
+    int MinKey();		// The smallest key; the tree must not
+				// be empty
+    bool IsEmpty() { return (root == NULL); }
+    void Mapcar(VoidFunctionPtr func);
+				// Apply "func" to every item, in order
+
+  private:
+    TreeNode *Insert(TreeNode *tree, TreeNode *node);
+				// Put "node" in "tree"; return the new root
+    TreeNode *RemoveMin(TreeNode *tree, TreeNode **minPtr);
+				// Take the first node out of "tree"; return
+				// the new root
+    TreeNode *Rebalance(TreeNode *tree);
+				// Restore the balance at "tree", whose
+				// subtrees are balanced; return the new root
+    void Walk(TreeNode *tree, VoidFunctionPtr func);
+
+    TreeNode *root;		// NULL if the tree is empty
+    unsigned int nextOrder;	// "order" for the next item put in
+    TreeNode *freeNodes;	// nodes no longer in use, for re-use
+};
+
+#endif // SORTEDTREE_H
@@ -18,8 +18,7 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
-List *timerQueue;   // Queue of events waiting on the timer
-bool initializedConsoleSemaphores;  // For conosle
+TimingWheel *timerQueue;   // Threads sleeping until a given time
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -31,6 +30,18 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+BitMap *frameMap;	// which physical frames are in use
+TextCache *textCache;	// frames of code, shared by program
+#endif
+
+#ifdef VM
+FrameTable *frameTable;
+SwapSpace *swapSpace;
+#endif
+
+#ifdef USE_TLB
+InvertedPageTable *invertedPageTable;
+TLBReplacement tlbReplacement;
 #endif
 
 #ifdef NETWORK
@@ -55,33 +66,41 @@ extern void Cleanup();
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	Threads that are due to wake up from a Sleep system call are put
+//	back on the ready list.  If we are idle (the current thread is
+//	asleep, waiting for something to run) and still nobody is ready,
+//	the timer need not interrupt again until the next one is due.
+//
+//	Then the scheduler charges the interrupted thread, and those on
+//	any other busy CPUs, for their time, and decides whether they
+//	have had their turn.
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(int dummy)
 {
-    //if (interrupt->getStatus() != IdleMode)
-	//interrupt->YieldOnReturn();
-    
-    // If the queue is empty return
-    if(timerQueue->IsEmpty()) {
-        return;
-    }
-    
-    int key;
     Thread *readyThread;
+    bool woke = FALSE;
     
-    // Loop throught the queue and see if any of the elements is ready to be
-    // woken up, in such a case obtain it's key and set it to readytorun
-    while(!(timerQueue->IsEmpty()) && timerQueue->firstKey() <= stats->totalTicks ) {
-        readyThread = (Thread *)timerQueue->SortedRemove(&key);
+    // Take off the wheel every thread that is ready to be woken up, 
+    // and set it to readytorun
+    while ((readyThread = (Thread *)timerQueue->RemoveDue(stats->totalTicks))
+								!= NULL) {
         DEBUG('T', "\"%s\" is being woken from sleep\n", readyThread->getName());
 
         // IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
         scheduler->ReadyToRun(readyThread);
         // (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+        woke = TRUE;
     }
+    if (!woke && !timerQueue->IsEmpty() && 
+				(currentThread->getStatus() == BLOCKED))
+	timer->SkipUntil(timerQueue->NextWakeup());
+
+    if (scheduler->Tick())
+	interrupt->YieldOnReturn();
 }
 
 //----------------------------------------------------------------------
@@ -100,10 +119,21 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
-    initializedConsoleSemaphores = FALSE;
+    int numCPUs = 1;		// simulated CPUs
+    SchedulingPolicy *schedPolicy = NULL;	// which thread runs next
+#ifdef USE_TLB
+    tlbReplacement = RandomTLB;
+#endif
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    ExecEngine engine = InterpretEngine;	// how to run user code
+    int quantum = 0;		// ticks per CPU per round, if non-zero
+    bool hostThreads = FALSE;	// run quanta on host threads
+    int tlbEntries = DefaultTLBSize;	// entries in each CPU's TLB
+#endif
+#ifdef VM
+    ReplacementPolicy *policy = NULL;	// how to choose pages to evict
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -128,10 +158,77 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sp")) {
+	    ASSERT(argc > 1);
+	    delete schedPolicy;
+	    if (!strcmp(*(argv + 1), "fifo"))
+		schedPolicy = new FIFOScheduling();
+	    else if (!strcmp(*(argv + 1), "fair"))
+		schedPolicy = new FairScheduling();
+	    else if (!strcmp(*(argv + 1), "stride"))
+		schedPolicy = new StrideScheduling();
+	    else {
+		ASSERT(!strcmp(*(argv + 1), "mlfq"));
+		schedPolicy = new FeedbackScheduling();
+	    }
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-e")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "block"))
+		engine = BlockEngine;
+	    else if (!strcmp(*(argv + 1), "threaded"))
+		engine = ThreadedEngine;
+	    else if (!strcmp(*(argv + 1), "batch"))
+		engine = BatchEngine;
+	    else
+		ASSERT(!strcmp(*(argv + 1), "interp"));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-P")) {
+	    ASSERT(argc > 1);
+	    numCPUs = atoi(*(argv + 1));
+	    ASSERT((numCPUs > 0) && (numCPUs <= MaxCPUs));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-q")) {
+	    ASSERT(argc > 1);
+	    quantum = atoi(*(argv + 1));
+	    ASSERT(quantum > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-H"))
+	    hostThreads = TRUE;
+#endif
+#ifdef USE_TLB
+	if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv + 1));
+	    ASSERT(tlbEntries > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tr")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "lru"))
+		tlbReplacement = LRUTLB;
+	    else {
+		ASSERT(!strcmp(*(argv + 1), "random"));
+		tlbReplacement = RandomTLB;
+	    }
+	    argCount = 2;
+	}
+#endif
+#ifdef VM
+	if (!strcmp(*argv, "-rp")) {
+	    ASSERT(argc > 1);
+	    delete policy;
+	    if (!strcmp(*(argv + 1), "fifo"))
+		policy = new FIFOPolicy();
+	    else {
+		ASSERT(!strcmp(*(argv + 1), "clock"));
+		policy = new ClockPolicy();
+	    }
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -153,8 +250,10 @@ Initialize(int argc, char **argv)
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
-    timerQueue = new List();        //list of threads waiting on the timer
+    if (schedPolicy == NULL)
+	schedPolicy = new FeedbackScheduling();
+    scheduler = new Scheduler(numCPUs, schedPolicy);	// initialize the ready queue
+    timerQueue = new TimingWheel(TimerTicks);	// threads sleeping on the timer
     // if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
     threadToBeDestroyed = NULL;
@@ -169,7 +268,13 @@ Initialize(int argc, char **argv)
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);	// this must come first
+    machine = new Machine(debugUserProg, engine, numCPUs, quantum,
+			  hostThreads, tlbEntries);	// this must come first
+    frameMap = new BitMap(NumPhysPages);
+    textCache = new TextCache();
+#endif
+#ifdef USE_TLB
+    invertedPageTable = new InvertedPageTable();
 #endif
 
 #ifdef FILESYS
@@ -180,6 +285,13 @@ Initialize(int argc, char **argv)
     fileSystem = new FileSystem(format);
 #endif
 
+#ifdef VM
+    if (policy == NULL)
+	policy = new ClockPolicy();
+    frameTable = new FrameTable(policy);
+    swapSpace = new SwapSpace(SwapFileName, NumSwapPages);
+#endif
+
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, 10);
 #endif
@@ -198,9 +310,19 @@ Cleanup()
 #endif
     
 #ifdef USER_PROGRAM
+#ifdef USE_TLB
+    delete invertedPageTable;
+#endif
+    delete textCache;
+    delete frameMap;
     delete machine;
 #endif
 
+#ifdef VM
+    delete swapSpace;
+    delete frameTable;
+#endif
+
 #ifdef FILESYS_NEEDED
     delete fileSystem;
 #endif
@@ -15,6 +15,7 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "timingwheel.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -28,12 +29,15 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
-extern List *timerQueue;            // queue of events waiting on a timer
-extern bool initializedConsoleSemaphores;   //For the console
+extern TimingWheel *timerQueue;     // threads sleeping until a given time
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "bitmap.h"
+#include "textcache.h"
 extern Machine* machine;	// user program memory and registers
+extern BitMap *frameMap;	// which physical frames are in use
+extern TextCache *textCache;	// frames of code, shared by program
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -41,6 +45,20 @@ extern Machine* machine;	// user program memory and registers
 extern FileSystem  *fileSystem;
 #endif
 
+#ifdef VM
+#include "frametable.h"
+#include "swap.h"
+extern FrameTable *frameTable;	// which page is in each frame
+extern SwapSpace *swapSpace;	// where pages go when memory is full
+#endif
+
+#ifdef USE_TLB
+#include "ipt.h"
+extern InvertedPageTable *invertedPageTable;
+				// where TLB misses are refilled from
+extern TLBReplacement tlbReplacement;	// which TLB entry a miss replaces
+#endif
+
 #ifdef FILESYS
 #include "synchdisk.h"
 extern SynchDisk   *synchDisk;
@@ -33,10 +33,14 @@
 //----------------------------------------------------------------------
 
 // The thread count stores the total number of threads that are alive right now
-// This is unlike the pidCount which just stores the last alloted pid and wraps
-// afte the pids exhaust
 int Thread::threadCount= 0;
-int Thread::pidCount = 0;
+
+// The pid allocator's state; freeCount == -1 until the first pid is
+// allocated, when the queue is filled
+Thread *Thread::pidTable[MAX_THREADS];
+int Thread::freePids[MAX_THREADS];
+int Thread::freeHead = 0;
+int Thread::freeCount = -1;
 
 Thread::Thread(char* threadName)
 {
@@ -49,25 +53,33 @@ Thread::Thread(char* threadName)
     // Initialize the parent to be NULL
     parent = NULL;
 
-    // The following two arrays maintain a sort of hash map for the status of
-    // the children
-    child_status = new int[MAX_THREADS];
-    child_pids = new int[MAX_THREADS];
+    // The following two arrays maintain a hash map for the status of the
+    // children; most threads never have any, so they start out empty
+    childSlots = 0;
+    child_status = NULL;
+    child_pids = NULL;
 
-    // Assign a PID to the process
-    pidCount = (pidCount + 1) % MAX_THREADS;
-    pid = pidCount;
+    // Assign a PID to the process, and index the thread by it
+    pid = AllocatePid();
+    pidTable[pid] = this;
 
     // Increment the thread count
     ++threadCount;
     
     // Assign the parent PID, zero for the first thread
-    if(pid == 1) {
+    if(currentThread == NULL) {
         ppid = 0;
     } else {
         ppid = currentThread->getPid();
     }
 
+    // Start at the top of the creator's priorities
+    basePriority = (currentThread == NULL) ? 0 : currentThread->basePriority;
+    priority = basePriority;
+    ticksUsed = 0;
+    virtualTime = 0;
+    readySince = 0;
+
 #ifdef USER_PROGRAM
     space = NULL;
 #endif
@@ -92,6 +104,72 @@ Thread::~Thread()
     ASSERT(this != currentThread);
     if (stack != NULL)
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    if (child_pids != NULL) {
+	// Our children outlive us; they must not signal us when they exit
+	for (int i = 0; i < childSlots; i++) {
+	    Thread *child = (child_pids[i] == NO_CHILD) ? NULL 
+						: Lookup(child_pids[i]);
+	    if ((child != NULL) && (child->parent == this))
+		child->parent = NULL;
+	}
+	delete [] child_pids;
+	delete [] child_status;
+    }
+#ifdef USER_PROGRAM
+    delete space;				// frees its physical frames
+#endif
+    pidTable[pid] = NULL;
+    FreePid(pid);
+}
+
+//----------------------------------------------------------------------
+// Thread::AllocatePid
+// 	Return a pid that no live thread has.  Pids come off the front of
+//	the queue of free pids, and go back on the end, so each pid is
+//	left unused for as long as possible after its thread is gone.
+//----------------------------------------------------------------------
+
+int
+Thread::AllocatePid()
+{
+    int newPid;
+
+    if (freeCount < 0) {			// first time: every pid
+	freeCount = 0;				// but 0 is free
+	for (int i = 1; i < MAX_THREADS; i++)
+	    FreePid(i);
+    }
+    ASSERT(freeCount > 0);			// too many threads
+    newPid = freePids[freeHead];
+    freeHead = (freeHead + 1) % MAX_THREADS;
+    freeCount--;
+    return newPid;
+}
+
+//----------------------------------------------------------------------
+// Thread::FreePid
+// 	Put a pid on the end of the queue of free pids.
+//----------------------------------------------------------------------
+
+void
+Thread::FreePid(int oldPid)
+{
+    ASSERT(freeCount < MAX_THREADS);
+    freePids[(freeHead + freeCount) % MAX_THREADS] = oldPid;
+    freeCount++;
+}
+
+//----------------------------------------------------------------------
+// Thread::Lookup
+// 	Return the live thread with pid "which", or NULL if there is none.
+//----------------------------------------------------------------------
+
+Thread *
+Thread::Lookup(int which)
+{
+    if ((which <= 0) || (which >= MAX_THREADS))
+	return NULL;
+    return pidTable[which];
 }
 
 //----------------------------------------------------------------------
@@ -227,7 +305,8 @@ Thread::Yield ()
 //	back on the ready queue, so that it can be re-scheduled.
 //
 //	NOTE: if there are no threads on the ready queue, that means
-//	we have no thread to run.  "Interrupt::Idle" is called
+//	we have no thread to run.  If another CPU is running a thread,
+//	this CPU just goes idle.  Otherwise, "Interrupt::Idle" is called
 //	to signify that we should idle the CPU until the next I/O interrupt
 //	occurs (the only thing that could cause a thread to become
 //	ready to run).
@@ -249,8 +328,11 @@ Thread::Sleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
-    while ((nextThread = scheduler->FindNextToRun()) == NULL)
+    while ((nextThread = scheduler->FindNextToRun()) == NULL) {
+	if (scheduler->IdleCPU())
+	    return;		// returns when we've been signalled
 	interrupt->Idle();	// no one to run, wait for an interrupt
+    }
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
@@ -386,14 +468,63 @@ Thread::decrementChildCount() {
 
 //----------------------------------------------------------------------
 // Thread:initializeChildStatus
-// Insert a new child and then set the state of the child to CHILD_LIVE
+// Insert a new child and then set the state of the child to CHILD_LIVE.
+// If pids have wrapped around and an old child had the same pid, the
+// new child takes its place.
 //----------------------------------------------------------------------
 void
 Thread::initializeChildStatus(int child_pid) {
 	DEBUG('J', "Adding %d to the child list of %d\n", child_pid, pid);
-    child_pids[childCount] = child_pid;
-    child_status[childCount] = CHILD_LIVE;
-    incrementChildCount();
+    int index = searchChildPid(child_pid);
+
+    if(index == CHILD_NOT_FOUND) {
+        // Keep the table at most half full, so that searches are short
+        if(2 * (childCount + 1) > childSlots) {
+            growChildTable();
+        }
+        index = child_pid & (childSlots - 1);
+        while(child_pids[index] != NO_CHILD) {
+            index = (index + 1) & (childSlots - 1);
+        }
+        child_pids[index] = child_pid;
+        incrementChildCount();
+    }
+    child_status[index] = CHILD_LIVE;
+}
+
+//----------------------------------------------------------------------
+// Thread::growChildTable
+// Double the size of the child table (or allocate the first one), and
+// put every child back in the slot for its pid
+//----------------------------------------------------------------------
+void
+Thread::growChildTable() {
+    int *old_pids = child_pids;
+    int *old_status = child_status;
+    int oldSlots = childSlots;
+    int index;
+
+    childSlots = (oldSlots == 0) ? MIN_CHILD_SLOTS : 2 * oldSlots;
+    child_pids = new int[childSlots];
+    child_status = new int[childSlots];
+    for(int i = 0; i < childSlots; ++i) {
+        child_pids[i] = NO_CHILD;
+    }
+
+    for(int i = 0; i < oldSlots; ++i) {
+        if(old_pids[i] != NO_CHILD) {
+            index = old_pids[i] & (childSlots - 1);
+            while(child_pids[index] != NO_CHILD) {
+                index = (index + 1) & (childSlots - 1);
+            }
+            child_pids[index] = old_pids[i];
+            child_status[index] = old_status[i];
+        }
+    }
+    if(old_pids != NULL) {
+        delete [] old_pids;
+        delete [] old_status;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -434,14 +565,54 @@ Thread::setChildStatus(int child_pid, int status) {
     }
 }
 
+//----------------------------------------------------------------------
+// Thread::removeChildStatus
+// Forget the child with the given pid, once its exit status has been
+// collected.  Children further along the same run of slots are moved
+// back into the gap, so that each can still be found from its pid's
+// own slot without leaving a marker behind.
+//----------------------------------------------------------------------
+void
+Thread::removeChildStatus(int child_pid) {
+    int index = searchChildPid(child_pid);
+    int mask = childSlots - 1;
+    int next, home;
+
+    if(index == CHILD_NOT_FOUND) {
+        return;
+    }
+    DEBUG('J', "Removing %d from the child list of %d\n", child_pid, pid);
+    child_pids[index] = NO_CHILD;
+    for(next = (index + 1) & mask; child_pids[next] != NO_CHILD; 
+                                        next = (next + 1) & mask) {
+        // The child can move back if the gap is no further from its
+        // own slot than where it is now
+        home = child_pids[next] & mask;
+        if(((next - home) & mask) >= ((next - index) & mask)) {
+            child_pids[index] = child_pids[next];
+            child_status[index] = child_status[next];
+            child_pids[next] = NO_CHILD;
+            index = next;
+        }
+    }
+    decrementChildCount();
+}
+
 //----------------------------------------------------------------------
 // Thread::searchChildPid
-// Search the child_pids array of the parent looking for the given pid
+// Search the child_pids table of the parent looking for the given pid,
+// and return its slot.  The search starts at the slot for the pid, and
+// stops at the first unused one.
 //----------------------------------------------------------------------
 int
 Thread::searchChildPid(int child_pid) {
-    // Loop through the child pids to get the index and then update
-    for(int i = 0; i< childCount; ++i) {
+    if(childSlots == 0) {
+        return CHILD_NOT_FOUND;
+    }
+
+    // Probe from the pid's own slot to get the index
+    for(int i = child_pid & (childSlots - 1); child_pids[i] != NO_CHILD; 
+                                        i = (i + 1) & (childSlots - 1)) {
         if(child_pids[i] == child_pid){
             return i;
         }
@@ -468,7 +639,7 @@ forkStart(int arg) {
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
         currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
+	scheduler->LoadSpace();
     }
 #endif
 
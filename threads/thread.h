@@ -39,6 +39,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "typedlist.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -57,6 +58,13 @@
 #define CHILD_NOT_FOUND -1
 #define MAX_THREADS 10000
 
+// The child table is a hash table on the child's pid, allocated when
+// the first child is added, and doubled whenever it gets half full.
+// A child leaves it once Join has collected its exit status, so it
+// only grows with the children not yet joined.
+#define NO_CHILD -1			// pid in an unused slot
+#define MIN_CHILD_SLOTS 8		// size of a new child table
+
 // Size of the thread's private execution stack.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
@@ -87,8 +95,8 @@ class Thread {
     int machineState[MachineStateSize];  // all registers except for stackTop
 
   public:
-    static int pidCount;            // Maintain a count of pids
     static int threadCount;         // Maintains a count of total threads
+    static Thread *Lookup(int which); // The live thread with this pid, or NULL
 
     Thread(char* debugName);		// initialize a Thread 
     ~Thread(); 				// deallocate a Thread
@@ -108,13 +116,31 @@ class Thread {
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
    
     // A public pointer the parent 
     Thread *parent;
 
-    // To store the child pid
+    // The link for the list of threads the thread is waiting on, if
+    // any: a ready list, or a semaphore's queue
+    ListLink<Thread> queueLink;
+
+    // Scheduling state, kept by the Scheduler
+    int priority;			// which ready queue the thread goes
+					// on; 0 is the highest priority
+    int basePriority;			// the highest it may have, set by
+					// SetPriority; it returns there after
+					// sleeping
+    int ticksUsed;			// time used so far at "priority",
+					// or in this time slice
+    int virtualTime;			// CPU time used, weighted by base
+					// priority, for the fair and stride
+					// policies
+    int readySince;			// when it was last made ready
+
+    // To store the child pid, hashed by pid (NULL if no children)
     int *child_pids;
 
     // Return the threads pid
@@ -125,11 +151,12 @@ class Thread {
     					// Allocate a stack for thread.
 					// Used internally by Fork()
   private:
-    // To store the state of the children
+    // To store the state of the children, in the same slot as their pid
     int *child_status;
 
     // some of the private data for this class is listed above
     int childCount;         // To store the number of children of the thread 
+    int childSlots;         // Size of the child table, a power of two
     int* stack; 	 		// Bottom of the stack 
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
@@ -138,6 +165,17 @@ class Thread {
 
     int pid, ppid;			// My pid and my parent's pid
 
+    // Pids are handed out from a queue of free pids, so that a pid is
+    // not reused while its thread is alive, and is reused as late as
+    // possible after that.  Pid 0 is never used; it is the ppid of
+    // the first thread.
+    static Thread *pidTable[MAX_THREADS];  // The thread with each pid
+    static int freePids[MAX_THREADS];   // Queue of free pids, circular
+    static int freeHead;                // Index of the next pid to use
+    static int freeCount;               // Number of pids in the queue
+    static int AllocatePid();           // Take a pid off the queue
+    static void FreePid(int oldPid);    // Put a pid back on the queue
+
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
 // one for its state while executing user code, one for its state 
@@ -155,6 +193,8 @@ class Thread {
     void initializeChildStatus(int child_pid); 
     int getChildStatus(int child_pid);
     void setChildStatus(int child_pid, int status);
+    void removeChildStatus(int child_pid);  // Forget a child, once joined
+    void growChildTable();          // Double the size of the child table
 
     // To maintain the child counts
     void incrementChildCount();     // Increments the count of the number of variables
@@ -163,6 +203,9 @@ class Thread {
 #endif
 };
 
+// A list of waiting threads, linked through the threads themselves
+typedef TypedList<Thread, &Thread::queueLink> ThreadList;
+
 // Magical machine-dependent routines, defined in switch.s
 
 extern "C" {
@@ -5,12 +5,16 @@
 //	back and forth between themselves by calling Thread::Yield, 
 //	to illustratethe inner workings of the thread system.
 //
+//	Also, a performance test of the pending interrupt queue.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
 #include "system.h"
+#include "synchlist.h"
+#include <time.h>
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -49,3 +53,141 @@ ThreadTest()
     SimpleThread(0);
 }
 
+
+//----------------------------------------------------------------------
+// InterruptPerformance
+// 	Time the queue of pending interrupts (see Interrupt::Schedule).
+//	The interrupts are never fired, so the handler is a dummy.
+//
+//	First, "count" interrupts are queued, many of them due at the same
+//	time, and then taken off again, checking that they come out in
+//	order, and in the order they went in when due at the same time.
+//	Then, as in a running system, a queue of a few hundred interrupts
+//	has one removed and a later one added "count" times.
+//
+//	"count" is the number of interrupts to schedule in each test
+//----------------------------------------------------------------------
+
+static void
+NeverCalled(int arg)
+{
+    ASSERT(FALSE);
+}
+
+void
+InterruptPerformance(int count)
+{
+    PendingQueue *queue = new PendingQueue();
+    PendingInterrupt toOccur;
+    int i, lastWhen, lastArg;
+    clock_t start;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+	queue->Insert(NeverCalled, i, Random() % (count / 8 + 1), TimerInt);
+    lastWhen = lastArg = -1;
+    for (i = 0; i < count; i++) {
+	queue->RemoveFirst(&toOccur);
+	ASSERT((toOccur.when > lastWhen) || 
+		((toOccur.when == lastWhen) && (toOccur.arg > lastArg)));
+	lastWhen = toOccur.when;
+	lastArg = toOccur.arg;
+    }
+    ASSERT(queue->IsEmpty());
+    printf("Scheduled and removed %d interrupts in %.2f seconds\n", count,
+		(double) (clock() - start) / CLOCKS_PER_SEC);
+
+    start = clock();
+    for (i = 0; i < 500; i++)
+	queue->Insert(NeverCalled, i, Random() % 1000, DiskInt);
+    for (i = 0; i < count; i++) {
+	queue->RemoveFirst(&toOccur);
+	queue->Insert(NeverCalled, i, toOccur.when + 1 + Random() % 1000,
+								DiskInt);
+    }
+    printf("Fired and rescheduled %d interrupts in %.2f seconds\n", count,
+		(double) (clock() - start) / CLOCKS_PER_SEC);
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// ListPerformance
+// 	Time a List against a TypedList, as used for waiting threads, and
+//	a SynchList, as used for the messages in a mailbox: "count" times,
+//	an item is taken off the front of a list of a few hundred and put
+//	back on the end.  The List allocates a ListElement each time, and
+//	frees one; the TypedList just changes two links, and the SynchList
+//	does the same inside its lock.  The items come out in the same
+//	order from all three.
+//
+//	"count" is the number of items to move on each list
+//----------------------------------------------------------------------
+
+class BenchItem {
+  public:
+    int value;			// which item this is
+    ListLink<BenchItem> link;	// for the TypedList and the SynchList
+};
+
+typedef TypedList<BenchItem, &BenchItem::link> BenchList;
+typedef SynchList<BenchItem, &BenchItem::link> SynchBenchList;
+
+void
+ListPerformance(int count)
+{
+    BenchItem *items = new BenchItem[500];
+    List *list = new List;
+    BenchList *typedList = new BenchList;
+    SynchBenchList *synchList;
+    BenchItem *item;
+    int i, listSum, typedSum, synchSum;
+    clock_t start;
+
+    for (i = 0; i < 500; i++)
+	items[i].value = i;
+
+    for (i = 0; i < 500; i++)
+	list->Append((void *)&items[i]);
+    listSum = 0;
+    start = clock();
+    for (i = 0; i < count; i++) {
+	item = (BenchItem *)list->Remove();
+	listSum += item->value;
+	list->Append((void *)item);
+    }
+    printf("Moved %d items on a List in %.2f seconds\n", count,
+		(double) (clock() - start) / CLOCKS_PER_SEC);
+    delete list;
+
+    for (i = 0; i < 500; i++)
+	typedList->Append(&items[i]);
+    typedSum = 0;
+    start = clock();
+    for (i = 0; i < count; i++) {
+	item = typedList->Remove();
+	typedSum += item->value;
+	typedList->Append(item);
+    }
+    printf("Moved %d items on a TypedList in %.2f seconds\n", count,
+		(double) (clock() - start) / CLOCKS_PER_SEC);
+    delete typedList;			// takes the items off again
+
+    synchList = new SynchBenchList;
+    for (i = 0; i < 500; i++)
+	synchList->Append(&items[i]);
+    synchSum = 0;
+    start = clock();
+    for (i = 0; i < count; i++) {
+	item = synchList->Remove();
+	synchSum += item->value;
+	synchList->Append(item);
+    }
+    printf("Moved %d items on a SynchList in %.2f seconds\n", count,
+		(double) (clock() - start) / CLOCKS_PER_SEC);
+    for (i = 0; i < 500; i++)
+	(void) synchList->Remove();
+    delete synchList;
+
+    ASSERT((typedSum == listSum) && (synchSum == listSum));
+    delete [] items;
+}
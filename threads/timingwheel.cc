@@ -0,0 +1,309 @@
+// timingwheel.cc
+//	Routines to manage a hierarchical timing wheel.  See
+//	timingwheel.h for how it is organized.
+//
+//	Slot numbers only ever grow, so the list for slot "s" at level
+//	"l" is lists[l][(s >> (WheelBits * l)) % WheelSlots].  An item
+//	due "d" slots from now is at the lowest level whose lists cover
+//	d slots; so every item at level 0 is due within one slot, and
+//	those lists can be checked directly.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "timingwheel.h"
+#include "interrupt.h"
+
+//----------------------------------------------------------------------
+// Link, Unlink
+// 	Put an entry at the end of a circular list, or take it off.
+//----------------------------------------------------------------------
+
+static void
+Link(WheelEntry *list, WheelEntry *entry)
+{
+    entry->prev = list->prev;
+    entry->next = list;
+    list->prev->next = entry;
+    list->prev = entry;
+}
+
+static void
+Unlink(WheelEntry *entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::TimingWheel
+// 	Initialize an empty timing wheel, starting at time 0.
+//
+//	"ticksPerSlot" -- how finely the wheel divides time; items due
+//		in the same slot are sorted out when they come due
+//----------------------------------------------------------------------
+
+TimingWheel::TimingWheel(int ticksPerSlot)
+{
+    ASSERT(ticksPerSlot > 0);
+    granularity = ticksPerSlot;
+    current = 0;
+    numEntries = 0;
+    nextOrder = 0;
+    for (int level = 0; level < WheelLevels; level++)
+	for (int i = 0; i < WheelSlots; i++)
+	    lists[level][i].prev = lists[level][i].next = &lists[level][i];
+    due.prev = due.next = &due;
+    freeEntries = NULL;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::~TimingWheel
+// 	De-allocate the wheel's entries.  The items on it are not ours
+//	to de-allocate.
+//----------------------------------------------------------------------
+
+TimingWheel::~TimingWheel()
+{
+    WheelEntry *entry;
+    int level, i;
+
+    for (level = 0; level < WheelLevels; level++)
+	for (i = 0; i < WheelSlots; i++)
+	    while (lists[level][i].next != &lists[level][i]) {
+		entry = lists[level][i].next;
+		Unlink(entry);
+		delete entry;
+	    }
+    while (due.next != &due) {
+	entry = due.next;
+	Unlink(entry);
+	delete entry;
+    }
+    while (freeEntries != NULL) {
+	entry = freeEntries;
+	freeEntries = entry->next;
+	delete entry;
+    }
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Insert
+// 	Put an item on the wheel, to be taken off by RemoveDue once
+//	"when" has arrived.  Items due at the same time come off in the
+//	order they went on.
+//
+//	Returns the entry for the item, which can be passed to Cancel.
+//
+//	"item" -- the thing that is waiting
+//	"when" -- the tick it should be taken off at
+//----------------------------------------------------------------------
+
+WheelEntry *
+TimingWheel::Insert(void *item, int when)
+{
+    WheelEntry *entry = freeEntries;
+
+    if (entry != NULL)
+	freeEntries = entry->next;
+    else
+	entry = new WheelEntry;
+    entry->item = item;
+    entry->when = when;
+    entry->order = nextOrder++;
+    Place(entry);
+    numEntries++;
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Cancel
+// 	Take an item off the wheel before RemoveDue has returned it.
+//	"entry" is no longer valid afterwards.
+//----------------------------------------------------------------------
+
+void
+TimingWheel::Cancel(WheelEntry *entry)
+{
+    Unlink(entry);
+    numEntries--;
+    entry->next = freeEntries;
+    freeEntries = entry;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::RemoveDue
+// 	Take an item that is due by "now" off the wheel, and return it.
+//	Returns NULL if there is nothing due.
+//----------------------------------------------------------------------
+
+void *
+TimingWheel::RemoveDue(int now)
+{
+    WheelEntry *entry;
+
+    if (numEntries == 0)
+	return NULL;
+    Advance(now);
+    entry = due.next;
+    if (entry == &due)
+	return NULL;
+    Cancel(entry);
+    return entry->item;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::NextWakeup
+// 	Return a time before which nothing on the wheel is due, so that
+//	whoever calls RemoveDue need not call it before then.  Items at
+//	level 0 tell us their time exactly; for those further up, we
+//	only know the start of the group of slots they are in.
+//----------------------------------------------------------------------
+
+int
+TimingWheel::NextWakeup()
+{
+    int level, i, slot, group, wakeup = NeverDue;
+    WheelEntry *entry, *list;
+
+    if (due.next != &due)
+	return due.next->when;
+    for (i = 0; i < WheelSlots; i++) {
+	list = &lists[0][(current + i) % WheelSlots];
+	if (list->next != list) {
+	    for (entry = list->next; entry != list; entry = entry->next)
+		if (entry->when < wakeup)
+		    wakeup = entry->when;
+	    break;
+	}
+    }
+    for (level = 1; level < WheelLevels; level++) {
+	group = current >> (WheelBits * level);
+	for (i = 1; i <= WheelSlots; i++) {
+	    list = &lists[level][(group + i) % WheelSlots];
+	    if (list->next != list) {
+		slot = (group + i) << (WheelBits * level);
+		if (slot < wakeup / granularity)
+		    wakeup = slot * granularity;
+		break;
+	    }
+	}
+    }
+    return wakeup;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Place
+// 	Put an entry on the list for its due time: at the lowest level
+//	whose lists reach far enough ahead.  Anything already due goes
+//	on the current slot's list, to be found by the next Advance;
+//	anything further ahead than the top level reaches goes on the
+//	furthest list there, and is placed again when that is cascaded.
+//----------------------------------------------------------------------
+
+void
+TimingWheel::Place(WheelEntry *entry)
+{
+    int slot = entry->when / granularity;
+    int ahead, level;
+
+    if (slot < current)
+	slot = current;
+    ahead = slot - current;
+    for (level = 0; level < WheelLevels - 1; level++)
+	if (ahead < (1 << (WheelBits * (level + 1))))
+	    break;
+    if (ahead >= (1 << (WheelBits * WheelLevels)))
+	slot = current + (1 << (WheelBits * WheelLevels)) - 1;
+    Link(&lists[level][(slot >> (WheelBits * level)) % WheelSlots], entry);
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Advance
+// 	Move every entry due by "now" onto the list of due entries,
+//	stepping through the slots since the last call.  Each time we
+//	reach the start of a group of slots, the next level's list for
+//	it is cascaded down.
+//
+//	The slot "now" is in is checked, but not passed: entries in it
+//	that are not quite due yet stay there for next time.
+//----------------------------------------------------------------------
+
+void
+TimingWheel::Advance(int now)
+{
+    int target = now / granularity;
+    WheelEntry *list, *entry, *next;
+    int level;
+
+    for (;;) {
+	list = &lists[0][current % WheelSlots];
+	for (entry = list->next; entry != list; entry = next) {
+	    next = entry->next;
+	    if (entry->when <= now) {
+		Unlink(entry);
+		MakeDue(entry);
+	    }
+	}
+	if (current >= target)
+	    break;
+	current++;
+	for (level = 1; level < WheelLevels; level++)
+	    if ((current & ((1 << (WheelBits * level)) - 1)) != 0 ||
+						(Cascade(level) != 0))
+		break;
+    }
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Cascade
+// 	We have just reached the start of a group of slots at "level";
+//	move the entries on that group's list down to lower levels.
+//
+//	Returns the index of the list, which is 0 once every group at
+//	this level has been passed -- time to cascade the next level up.
+//----------------------------------------------------------------------
+
+int
+TimingWheel::Cascade(int level)
+{
+    int index = (current >> (WheelBits * level)) % WheelSlots;
+    WheelEntry *list = &lists[level][index];
+    WheelEntry *entry;
+    WheelEntry moving;
+
+    if (list->next == list)
+	return index;
+    moving.next = list->next;		// take the whole list off first,
+    moving.prev = list->prev;		// since some entries may go
+    moving.next->prev = &moving;	// right back on it
+    moving.prev->next = &moving;
+    list->prev = list->next = list;
+    while (moving.next != &moving) {
+	entry = moving.next;
+	Unlink(entry);
+	Place(entry);
+    }
+    return index;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::MakeDue
+// 	Put an entry on the list of due entries, sorted by due time,
+//	and by the order they were inserted in.  Entries mostly come due
+//	in order, so we look for the place from the end.
+//----------------------------------------------------------------------
+
+void
+TimingWheel::MakeDue(WheelEntry *entry)
+{
+    WheelEntry *after;
+
+    for (after = due.prev; after != &due; after = after->prev)
+	if ((after->when < entry->when) || ((after->when == entry->when) &&
+			((int) (after->order - entry->order) < 0)))
+	    break;
+    Link(after->next, entry);		// i.e., just before after->next
+}
@@ -0,0 +1,82 @@
+// timingwheel.h
+//	Data structures for a hierarchical timing wheel: a queue of
+//	items, each to be taken off at some time in the future (e.g.,
+//	threads sleeping until a given tick).
+//
+//	Time is divided into "slots" of a fixed number of ticks.  The
+//	first level of the wheel has one list for each of the next
+//	WheelSlots slots; each higher level has one list for each of the
+//	next WheelSlots groups of slots of the level below it.  An item
+//	goes on a list by its due time, so putting it on or taking it
+//	off takes constant time, however many items there are.  As time
+//	goes by, the list for the next group at each level is "cascaded"
+//	down into the level below.
+//
+//	Unlike List::SortedInsert, nothing ever walks the whole queue.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define WheelBits	6			// log2 of lists per level
+#define WheelSlots	(1 << WheelBits)	// lists per level
+#define WheelLevels	4			// covers 2^24 slots ahead
+
+// The following class defines one item on a timing wheel.  It is
+// handed back by TimingWheel::Insert, so that it can be cancelled.
+
+class WheelEntry {
+  public:
+    void *item;			// the thing that is waiting
+    int when;			// when it is due, in ticks
+    unsigned int order;		// when it was inserted, relative to
+				// others due at the same time
+    WheelEntry *prev;		// the rest of its list; each list is
+    WheelEntry *next;		// circular, through a dummy entry
+};
+
+// The following class defines a timing wheel.
+
+class TimingWheel {
+  public:
+    TimingWheel(int ticksPerSlot);	// initialize an empty wheel
+    ~TimingWheel();			// de-allocate the wheel
+
+    WheelEntry *Insert(void *item, int when);
+				// Put "item" on the wheel, due at "when"
+    void Cancel(WheelEntry *entry);
+				// Take an item back off, before it is due
+    void *RemoveDue(int now);	// Take off an item due by "now", earliest
+				// first; NULL if there are none
+    bool IsEmpty() { return (numEntries == 0); }
+    int NextWakeup();		// No item is due before this time;
+				// NeverDue if the wheel is empty
+
+  private:
+    void Place(WheelEntry *entry);
+				// Put an entry on the right list for
+				// its due time
+    void Advance(int now);	// Move everything due by "now" onto "due"
+    int Cascade(int level);	// Re-place the list at "level" for the
+				// slot we have just reached
+    void MakeDue(WheelEntry *entry);
+				// Put an entry on "due", in order
+
+    int granularity;		// ticks per slot
+    int current;		// the earliest slot not yet past
+    int numEntries;		// items on the wheel
+    unsigned int nextOrder;	// "order" for the next item inserted
+    WheelEntry lists[WheelLevels][WheelSlots];
+				// dummy entries, heading each list
+    WheelEntry due;		// dummy entry, heading the items already
+				// due, sorted by time
+    WheelEntry *freeEntries;	// entries no longer in use, for re-use
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,138 @@
+// typedlist.h
+//	Data structures for "intrusive" lists: singly-linked lists of
+//	objects of one type, linked through a ListLink inside each object.
+//
+//	Unlike List, which allocates a ListElement for every item put on
+//	it and frees it when the item comes off, a TypedList never
+//	allocates anything, and hands back items of the right type.  The
+//	price is that an object needs a ListLink for each list it can be
+//	on at the same time; e.g., a Thread is on at most one list of
+//	waiting threads (a ready list, or a semaphore's queue) at once, so
+//	it has one link for all of them.
+//
+//	The lists are templates, so everything is here in the header.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TYPEDLIST_H
+#define TYPEDLIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the link an object of type T needs, to
+// be on a list of T's.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink() { next = NULL; onList = FALSE; }
+
+    T *next;			// next item on the list, NULL if last
+    bool onList;		// is the object on a list now?
+};
+
+// The following class defines a list of T's linked through the member
+// "link" of each.  E.g., TypedList<Thread, &Thread::queueLink>.
+
+template <class T, ListLink<T> T::*link>
+class TypedList {
+  public:
+    TypedList() { first = last = NULL; }	// initialize the list
+    ~TypedList() { while (Remove() != NULL) ; }
+				// take everything off; the items are not
+				// ours to de-allocate
+
+    void Append(T *item);	// Put item at the end of the list
+    void Prepend(T *item);	// Put item at the beginning of the list
+    T *Remove();		// Take item off the front of the list;
+				// NULL if the list is empty
+    bool IsEmpty() { return (first == NULL); }
+    void Mapcar(void (*func)(T *));
+				// Apply "func" to every item on the list
+
+  private:
+    T *first;			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+};
+
+//----------------------------------------------------------------------
+// TypedList::Append
+//	Put "item" at the end of the list.  It must not be on a list
+//	through the same link already.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*link>
+void
+TypedList<T, link>::Append(T *item)
+{
+    ASSERT(!(item->*link).onList);
+    (item->*link).onList = TRUE;
+    (item->*link).next = NULL;
+    if (first == NULL)
+	first = item;
+    else
+	(last->*link).next = item;
+    last = item;
+}
+
+//----------------------------------------------------------------------
+// TypedList::Prepend
+//	Put "item" at the beginning of the list.  It must not be on a
+//	list through the same link already.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*link>
+void
+TypedList<T, link>::Prepend(T *item)
+{
+    ASSERT(!(item->*link).onList);
+    (item->*link).onList = TRUE;
+    (item->*link).next = first;
+    if (first == NULL)
+	last = item;
+    first = item;
+}
+
+//----------------------------------------------------------------------
+// TypedList::Remove
+//	Take the first item off the list, and return it; NULL if the
+//	list is empty.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*link>
+T *
+TypedList<T, link>::Remove()
+{
+    T *item = first;
+
+    if (item == NULL)
+	return NULL;
+    first = (item->*link).next;
+    if (first == NULL)
+	last = NULL;
+    (item->*link).next = NULL;
+    (item->*link).onList = FALSE;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// TypedList::Mapcar
+//	Apply a function to each item on the list, in order.
+//
+//	"func" -- the procedure to apply; it must not change the list
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*link>
+void
+TypedList<T, link>::Mapcar(void (*func)(T *))
+{
+    for (T *item = first; item != NULL; item = (item->*link).next)
+	(*func)(item);
+}
+
+#endif // TYPEDLIST_H
@@ -20,13 +20,18 @@
 #include "addrspace.h"
 #include "noff.h"
 
-//----------------------------------------------------------------------
-// totalPagesCount 
-// this is a global variable that keeps a count of the number of pages that
-// have been used by processes up until now
-//----------------------------------------------------------------------
-// Initialize the value of the totalPagesCount to zero the very first time
-int totalPagesCount = 0;
+// The object code file a program is loaded from.  Under VM, its pages
+// are read in the first time the program touches them, so the file
+// stays open as long as the program, or any child forked from it, is
+// running; otherwise, it is only needed while the program is loaded.
+
+class Executable {
+  public:
+    OpenFile *file;		// the object code file
+    char *name;			// its name, to share its text by; or NULL
+    NoffHeader noffH;		// its header, in host byte order
+    int users;			// address spaces loading pages from it
+};
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -50,6 +55,73 @@ SwapHeader (NoffHeader *noffH)
 	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
 }
 
+// The number of address spaces mapping each physical frame.  A frame is
+// shared by a forked child and its parent until one of them writes to it,
+// and a frame of code by every address space running the program.  Under
+// VM, the frame table knows which pages they are, so that a shared frame
+// can be taken from all of them.
+
+static int frameUsers[NumPhysPages];
+
+//----------------------------------------------------------------------
+// ReleaseFrame
+// 	Stop using a physical frame; once no address space uses it, take
+//	it out of the text cache, and give it back to "frameMap" (through
+//	the frame table, under VM).
+//----------------------------------------------------------------------
+
+static void
+ReleaseFrame(int frame)
+{
+    ASSERT(frameUsers[frame] > 0);
+    if (--frameUsers[frame] == 0) {
+        textCache->Remove(frame);
+#ifdef VM
+        frameTable->Free(frame);
+#else
+        frameMap->Clear(frame);
+#endif
+    }
+}
+
+//----------------------------------------------------------------------
+// IsTextPage
+// 	Return TRUE if virtual page "vpn" holds nothing but code, so that
+//	it can be read-only, and shared by every address space running
+//	the same program.  The page where the code ends usually has data
+//	in it too.
+//----------------------------------------------------------------------
+
+static bool
+IsTextPage(NoffHeader *noffH, unsigned int vpn)
+{
+    int start = vpn * PageSize;
+
+    return (noffH->code.size > 0) && (start >= noffH->code.virtualAddr) &&
+        (start + PageSize <= noffH->code.virtualAddr + noffH->code.size);
+}
+
+//----------------------------------------------------------------------
+// LoadPart
+// 	Copy whatever part of "segment" lies in virtual page "vpn" from
+//	the object code file into physical frame "frame".
+//----------------------------------------------------------------------
+
+static void
+LoadPart(OpenFile *file, Segment *segment, unsigned int vpn, int frame)
+{
+    int start = vpn * PageSize;
+    int end = start + PageSize;
+
+    if (segment->virtualAddr > start)
+        start = segment->virtualAddr;
+    if (segment->virtualAddr + segment->size < end)
+        end = segment->virtualAddr + segment->size;
+    if (start < end)
+        file->ReadAt(&machine->mainMemory[frame * PageSize + start % PageSize],
+                end - start, segment->inFileAddr + start - segment->virtualAddr);
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
@@ -59,16 +131,19 @@ SwapHeader (NoffHeader *noffH)
 //	Assumes that the object code file is in NOFF format.
 //
 //	First, set up the translation from program memory to physical 
-//  memory.
-//  this works for a generic mapping
+//	memory, one frame per page; pages of code already loaded for
+//	another address space running "name" share its frames.  Under
+//	VM, pages are only loaded when the program first touches them,
+//	and the address space keeps "executable" open until then.
 //
 //	"executable" is the file containing the object code to load into memory
+//	"name" is the file's name, or NULL if its code is not to be shared
 //----------------------------------------------------------------------
 
-AddrSpace::AddrSpace(OpenFile *executable)
+AddrSpace::AddrSpace(OpenFile *executable, char *name)
 {
     NoffHeader noffH;
-    unsigned int i, size;
+    unsigned int i, size, imagePages, stackPages;
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
@@ -76,117 +151,529 @@ AddrSpace::AddrSpace(OpenFile *executable)
         SwapHeader(&noffH);
     ASSERT(noffH.noffMagic == NOFFMAGIC);
 
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
-        + UserStackSize;	// we need to increase the size
-    // to leave room for the stack
-    numPages = divRoundUp(size, PageSize);
-    size = numPages * PageSize;
-
-    ASSERT(numPages + totalPagesCount <= NumPhysPages);  // Ensure that the totalPages Count
-                                                // does not go beyond available
-                                                // pages
-
-    // We have to add the totalPagesCount to the physicalPage because of the new
-    // mapping function that we have used to allocate Pages
-    // first, set up the translation 
-    pageTable = new TranslationEntry[numPages];
-    for (i = 0; i < numPages; i++) {
-        pageTable[i].virtualPage = i;	
-        pageTable[i].physicalPage = i + totalPagesCount;
-        pageTable[i].valid = TRUE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
-        // a separate page, we could set its 
-        // pages to be read-only
+    // how big is address space?  The program's image is at the 
+    // bottom, and its stack at the top; the pages in between are
+    // not mapped, and cost nothing
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
+    imagePages = divRoundUp(size, PageSize);
+    stackPages = divRoundUp(UserStackSize, PageSize);
+    numPages = UserVirtPages;
+    if (imagePages + stackPages > numPages)
+        numPages = imagePages + stackPages;
+
+    program = new Executable;
+    program->file = executable;
+    if (name == NULL)
+        program->name = NULL;
+    else {
+        program->name = new char[strlen(name) + 1];
+        strcpy(program->name, name);
+    }
+    program->noffH = noffH;
+    program->users = 1;
+
+    // first, set up the translation; nothing is loaded yet
+    pageTable = new PageTable(numPages);
+    pageTable->Map(0, imagePages);
+    pageTable->Map(numPages - stackPages, stackPages);
+    for (i = 0; i < imagePages; i++)
+        pageTable->Info(i)->text = IsTextPage(&noffH, i);
+
+#ifdef VM
+    DEBUG('a', "Initializing address space, num pages %d, mapped %d, "
+            "loaded on demand\n", numPages, imagePages + stackPages);
+#else
+    DEBUG('a', "Initializing address space, num pages %d, mapped %d\n", 
+            numPages, imagePages + stackPages);
+    for (i = pageTable->NextMapped(0); i < numPages; 
+                                        i = pageTable->NextMapped(i + 1))
+        LoadPage(i);
+    DEBUG('a', "%d frames still free\n", frameMap->NumClear());
+
+    // the caller closes the file
+    ReleaseProgram();
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Create an address space for a forked child of the program
+//	running in "parentSpace".
+//  
+//  Rather than copying the parent's memory, the child's page table maps
+//  the same frames, and both are marked read-only: the first write to
+//  a page by either program raises a ReadOnlyException, and CopyOnWrite
+//  then gives it a copy of its own.  Pages the parent has not touched
+//  yet are left for the child to load from the same executable; those
+//  it has sent out to swap are copied to slots of the child's own.
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(AddrSpace *parentSpace)
+{ 
+    PageTable *parentTable = parentSpace->pageTable;
+    TranslationEntry *entry, *parentEntry;
+    PageInfo *info, *parentInfo;
+    unsigned int i;
+    int frame;
+
+    numPages = parentSpace->numPages;	// number of pages is equal to parent
+    program = parentSpace->program;
+    if (program != NULL)
+        program->users++;
+#ifdef USE_TLB
+    parentSpace->FlushTLB();		// bring its use and dirty bits up
+					// to date, and drop its writable
+					// translations
+#endif
+
+    DEBUG('a', "Initializing address space\nnum pages %d, size %d\n", 
+            numPages, numPages * PageSize);
+
+    // first, set up the translation, sharing every frame
+    pageTable = new PageTable(numPages);
+    for (i = parentTable->NextMapped(0); i < numPages; 
+                                        i = parentTable->NextMapped(i + 1)) {
+        pageTable->Map(i, 1);
+        info = pageTable->Info(i);
+        parentInfo = parentTable->Info(i);
+        info->text = parentInfo->text;
+        parentEntry = parentSpace->Resident(i);
+#ifdef VM
+        if ((parentEntry == NULL) && (parentInfo->swapSlot != -1))
+            CopySwapSlot(i, parentInfo->swapSlot);
+#endif
+        if (parentEntry == NULL)
+            continue;
+        frame = parentEntry->physicalPage;
+        if (!parentEntry->readOnly) {
+            parentEntry->readOnly = TRUE;
+            info->shared = parentInfo->shared = TRUE;
+        } else
+            info->shared = parentInfo->shared;
+        entry = MapFrame(i, frame, TRUE);
+        entry->dirty = !info->text;	// i.e., not in our swap slot (code
+					// is in the object code file)
+        frameUsers[frame]++;
     }
 
-    DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
-            numPages, size);
-   
-    // zero out the entire address space, to zero the unitialized data segment 
-    // and the stack segment
-    bzero((machine->mainMemory+totalPagesCount*PageSize), size);
-
-    // then, copy in the code and data segments into memory
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-               noffH.code.virtualAddr, noffH.code.size);
-        executable->ReadAt(&((machine->mainMemory+totalPagesCount*PageSize)[noffH.code.virtualAddr]),
-                noffH.code.size, noffH.code.inFileAddr);
+    // the parent's pages have just become read-only, so the machine
+    // must not go on writing them through translations it remembers
+    machine->FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::~AddrSpace
+// 	Dealloate an address space, giving back the frames no other
+//	address space is sharing.
+//----------------------------------------------------------------------
+
+AddrSpace::~AddrSpace()
+{
+    TranslationEntry *entry;
+    unsigned int i;
+    int frame;
+
+    for (i = pageTable->NextMapped(0); i < numPages; 
+                                        i = pageTable->NextMapped(i + 1)) {
+        entry = Resident(i);
+        if (entry != NULL) {
+            frame = entry->physicalPage;
+            UnmapFrame(i);
+            ReleaseFrame(frame);
+        }
+#ifdef VM
+        if (pageTable->Info(i)->swapSlot != -1)
+            swapSpace->Free(pageTable->Info(i)->swapSlot);
+#endif
     }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-                noffH.initData.virtualAddr, noffH.initData.size);
-        executable->ReadAt(&((machine->mainMemory+totalPagesCount*PageSize)[noffH.initData.virtualAddr]),
-                noffH.initData.size, noffH.initData.inFileAddr);
+    delete pageTable;
+    ReleaseProgram();
+    scheduler->ForgetSpace(this);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReleaseProgram
+// 	Stop loading pages from the object code file; once no address
+//	space is, close it (under VM; otherwise, the caller of the
+//	constructor does).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReleaseProgram()
+{
+    if ((program != NULL) && (--program->users == 0)) {
+#ifdef VM
+        delete program->file;
+#endif
+        delete [] program->name;
+        delete program;
     }
+    program = NULL;
+}
 
-    // Increment the totalPagesCount
-    totalPagesCount += numPages;
-    DEBUG('a', "totalPagesCount %d\n", totalPagesCount);
+//----------------------------------------------------------------------
+// AddrSpace::Resident
+// 	Return the translation of virtual page "vpn", if the page is
+//	mapped and in memory; otherwise NULL.  With a TLB, it is kept in
+//	the inverted page table, not in our page table.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+AddrSpace::Resident(unsigned int vpn)
+{
+#ifdef USE_TLB
+    return invertedPageTable->Lookup(this, vpn);
+#else
+    TranslationEntry *entry = pageTable->Entry(vpn);
+
+    if ((entry == NULL) || !entry->valid)
+        return NULL;
+    return entry;
+#endif
 }
 
 //----------------------------------------------------------------------
-// AddrSpace::AddrSpace
-// 	Create an address space to run a user program.
-//  
-//  Setup the translation table
-//  Copy the physical memoy of the parent into the new page table
+// AddrSpace::MapFrame
+// 	Record that virtual page "vpn" is in physical page "frame", and
+//	return its translation: valid, unused and clean, and read-only if
+//	"readOnly" is set.  Under VM, the frame table is told, so that the
+//	frame can be taken from us.
 //----------------------------------------------------------------------
-AddrSpace::AddrSpace(unsigned int numParentPages, unsigned int parentStartPhysPage)
-{ 
-    unsigned int i, k, size;
-    numPages = numParentPages;        // number of pages is equal to parent
-    size = numPages * PageSize;
-
-    ASSERT(numPages + totalPagesCount <= NumPhysPages);		// check we're not trying
-    // to run anything too big --
-    // at least until we have
-    // virtual memory
-
-    DEBUG('a', "Initializing address space\nparent pages %d num pages %d, size %d\n", 
-            numParentPages , numPages, size);
-
-    // first, set up the translation 
-    pageTable = new TranslationEntry[numPages];
-    for (i = 0; i < numPages; i++) {
-        pageTable[i].virtualPage = i;	
-        pageTable[i].physicalPage = i + totalPagesCount;
-        pageTable[i].valid = TRUE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
-        // a separate page, we could set its 
-        // pages to be read-only
+
+TranslationEntry *
+AddrSpace::MapFrame(unsigned int vpn, int frame, bool readOnly)
+{
+    TranslationEntry *entry;
+
+#ifdef USE_TLB
+    entry = invertedPageTable->Insert(this, vpn, frame, readOnly);
+#else
+    entry = pageTable->Entry(vpn);
+    entry->physicalPage = frame;
+    entry->valid = TRUE;
+    entry->readOnly = readOnly;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+#endif
+#ifdef VM
+    frameTable->AddUser(frame, this, vpn, entry);
+#endif
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::UnmapFrame
+// 	Record that virtual page "vpn" is no longer in memory.  What
+//	becomes of its frame is up to the caller.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::UnmapFrame(unsigned int vpn)
+{
+#ifdef VM
+    frameTable->RemoveUser(Resident(vpn)->physicalPage, this);
+#endif
+#ifdef USE_TLB
+    invertedPageTable->Remove(this, vpn);
+#else
+    TranslationEntry *entry = pageTable->Entry(vpn);
+
+    entry->valid = FALSE;
+    entry->physicalPage = -1;
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	Called on a ReadOnlyException at "virtAddr".  If the page is one
+//	shared since a Fork, give it a frame of its own, copying the
+//	shared one, and make it writable; if no other address space
+//	still uses the frame, it can just be made writable.
+//
+//	The page is copied aside before we let go of the shared frame,
+//	since under VM, finding a new frame may take that one.
+//
+//	Returns FALSE if the page really is read-only.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOnWrite(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *entry;
+    int oldFrame, newFrame;
+    bool dirty;
+    char buffer[PageSize];
+
+    if (!pageTable->IsMapped(vpn) || !pageTable->Info(vpn)->shared)
+        return FALSE;
+#ifdef USE_TLB
+    FlushTLB();				// the TLB has the old translation
+#endif
+    entry = Resident(vpn);
+    ASSERT(entry != NULL);		// it was just written to
+    oldFrame = entry->physicalPage;
+    if (frameUsers[oldFrame] > 1) {
+        bcopy(&machine->mainMemory[oldFrame * PageSize], buffer, PageSize);
+        dirty = entry->dirty;
+        UnmapFrame(vpn);
+        ReleaseFrame(oldFrame);
+#ifdef VM
+        newFrame = frameTable->Allocate();
+#else
+        newFrame = frameMap->Find();
+        ASSERT(newFrame != -1);		// out of memory, until we
+					// have virtual memory
+#endif
+        frameUsers[newFrame] = 1;
+        machine->InvalidateCodePage(newFrame);
+        bcopy(buffer, &machine->mainMemory[newFrame * PageSize], PageSize);
+        entry = MapFrame(vpn, newFrame, FALSE);
+        entry->dirty = dirty;
+        DEBUG('a', "Copied frame %d to %d for page %d\n", oldFrame, 
+                newFrame, vpn);
     }
+    entry->readOnly = FALSE;
+    pageTable->Info(vpn)->shared = FALSE;
+    machine->FlushSoftTLB();		// it may remember the old frame
+    return TRUE;
+}
 
-    // Now we have to copy the parent's code into the physical pages
-    unsigned int parentPhysEnd = (parentStartPhysPage + numPages) * PageSize; 
-    i = parentStartPhysPage * PageSize;
-    k = totalPagesCount * PageSize;
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Called on a PageFaultException at "virtAddr".  With a TLB, this
+//	is a TLB miss: the translation is looked up in the inverted page
+//	table, and put in the TLB.  Under VM, a page the program has not
+//	touched before (or that has been sent out to swap) is not there,
+//	and is loaded first.
+//
+//	Returns FALSE if the address is not in the address space at all.
+//----------------------------------------------------------------------
 
-    DEBUG('a', "Copying memory %d - %d to %d to %d\n", i, parentPhysEnd, k, k);
-    for(; i<parentPhysEnd; ++i, ++k) {
-        machine->mainMemory[k] = machine->mainMemory[i];
+bool
+AddrSpace::PageFault(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *entry;
+
+    if (!pageTable->IsMapped(vpn))
+        return FALSE;			// not mapped
+#ifdef USE_TLB
+    stats->numTLBMisses++;
+#endif
+    entry = Resident(vpn);
+#ifdef VM
+    if (entry == NULL) {
+        stats->numPageFaults++;
+        LoadPage(vpn);
+        entry = Resident(vpn);
     }
+#endif
+#ifdef USE_TLB
+    if (entry != NULL)
+        LoadTLB(entry);
+#endif
+    return (entry != NULL);
+}
 
-    // Increment the totalPagesCount
-    totalPagesCount += numPages;
-    DEBUG('a', "totalPagesCount %d\n", totalPagesCount);
+//----------------------------------------------------------------------
+// AddrSpace::LoadPage
+// 	Give virtual page "vpn" a frame, and fill it: from swap, if the
+//	page has been sent out there; otherwise with what the object code
+//	file has for the page -- code, initialized data, or zeroes for
+//	uninitialized data and the stack.
+//
+//	A page of code that is already loaded, for any address space
+//	running the same program, shares that frame instead.  (Only code
+//	pages are read-only before they are loaded.)  Under VM, code is
+//	never sent out to swap, since it is never written.
+//----------------------------------------------------------------------
 
+void
+AddrSpace::LoadPage(unsigned int vpn)
+{
+    PageInfo *info = pageTable->Info(vpn);
+    bool text = info->text && (program->name != NULL);
+    int frame = -1;
+
+    if (text)
+        frame = textCache->Find(program->name, vpn);
+    if (frame != -1) {
+        frameUsers[frame]++;
+        DEBUG('a', "Sharing frame %d for page %d\n", frame, vpn);
+    } else {
+#ifdef VM
+        frame = frameTable->Allocate();
+#else
+        frame = frameMap->Find();
+        ASSERT(frame != -1);		// check we're not trying
+					// to run anything too big --
+					// at least until we have
+					// virtual memory
+#endif
+        frameUsers[frame] = 1;
+
+        // the frame is about to be overwritten, so drop any instructions
+        // the simulator decoded from its previous contents
+        machine->InvalidateCodePage(frame);
+#ifdef VM
+        if (info->swapSlot != -1)
+            swapSpace->ReadPage(info->swapSlot, 
+                    &machine->mainMemory[frame * PageSize]);
+        else
+#endif
+        {
+            bzero(&machine->mainMemory[frame * PageSize], PageSize);
+            LoadPart(program->file, &program->noffH.code, vpn, frame);
+            LoadPart(program->file, &program->noffH.initData, vpn, frame);
+        }
+        if (text)
+            textCache->Add(program->name, vpn, frame);
+        DEBUG('a', "Loaded page %d into frame %d\n", vpn, frame);
+    }
+
+    // the page is clean, i.e., the same as in swap, or the object
+    // code file
+    MapFrame(vpn, frame, info->text);
 }
+
+#ifdef VM
 //----------------------------------------------------------------------
-// AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// AddrSpace::PageOut
+// 	Called by the frame table to take the frame away from virtual
+//	page "vpn".  The page is written out to swap, unless the copy
+//	there (or in the object code file, if it has never been sent out)
+//	is still up to date.
+//
+//	The frame may be shared, and is being taken from every address
+//	space using it; the frame table has the last one hand it over.
+//	A page shared until written gets a frame of its own when it is
+//	loaded again; a page of code is just loaded again from the object
+//	code file, and shared once more.
 //----------------------------------------------------------------------
 
-AddrSpace::~AddrSpace()
+void
+AddrSpace::PageOut(unsigned int vpn)
+{
+    TranslationEntry *entry = Resident(vpn);
+    PageInfo *info = pageTable->Info(vpn);
+    int frame;
+    bool dirty;
+
+    ASSERT(entry != NULL);
+    frame = entry->physicalPage;
+    dirty = entry->dirty;
+    UnmapFrame(vpn);
+    if (machine->ForgetFrame(frame))	// a TLB may know it was written
+        dirty = TRUE;
+    if (dirty) {
+        if (info->swapSlot == -1) {
+            info->swapSlot = swapSpace->Allocate();
+            ASSERT(info->swapSlot != -1);	// out of swap space
+        }
+        swapSpace->WritePage(info->swapSlot, 
+                &machine->mainMemory[frame * PageSize]);
+    }
+    info->shared = FALSE;
+    if (--frameUsers[frame] == 0)
+        textCache->Remove(frame);	// the frame is the frame table's
+    DEBUG('a', "Sent page %d out of frame %d\n", vpn, frame);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopySwapSlot
+// 	Give virtual page "vpn" a swap slot of its own, holding a copy of
+//	the page in slot "from" (another address space's).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CopySwapSlot(unsigned int vpn, int from)
+{
+    PageInfo *info = pageTable->Info(vpn);
+    char buffer[PageSize];
+
+    info->swapSlot = swapSpace->Allocate();
+    ASSERT(info->swapSlot != -1);	// out of swap space
+    swapSpace->ReadPage(from, buffer);
+    swapSpace->WritePage(info->swapSlot, buffer);
+}
+#endif
+
+#ifdef USE_TLB
+//----------------------------------------------------------------------
+// AddrSpace::LoadTLB
+// 	Put "translation" into the TLB, after a miss.  An empty entry is
+//	used if there is one; otherwise "tlbReplacement" chooses which
+//	entry to replace, and its use and dirty bits are copied back
+//	into the page table first.  Only the replaced page's translation
+//	need be dropped from those the machine remembers.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::LoadTLB(TranslationEntry *translation)
+{
+    int victim = -1;
+    unsigned int age, oldest = 0;
+
+    for (int i = 0; (i < machine->tlbSize) && (victim == -1); i++)
+        if (!machine->tlb[i].valid)
+            victim = i;
+    if (victim == -1) {
+        if (tlbReplacement == LRUTLB) {
+            for (int i = 0; i < machine->tlbSize; i++) {
+                age = *machine->tlbHits - machine->tlbLastUse[i];
+                if ((victim == -1) || (age > oldest)) {
+                    victim = i;
+                    oldest = age;
+                }
+            }
+        } else
+            victim = Random() % machine->tlbSize;
+        SaveTLBEntry(victim);
+        machine->FlushSoftPage(machine->tlb[victim].virtualPage);
+    }
+    machine->tlb[victim] = *translation;
+    machine->tlbLastUse[victim] = *machine->tlbHits;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SaveTLBEntry
+// 	Copy the use and dirty bits of entry "i" of the TLB back into the
+//	page table, through the inverted page table, and empty the entry.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SaveTLBEntry(int i)
 {
-   delete pageTable;
+    TranslationEntry *tlbEntry = &machine->tlb[i];
+    TranslationEntry *translation;
+
+    if (!tlbEntry->valid)
+        return;
+    translation = invertedPageTable->Lookup(this, tlbEntry->virtualPage);
+    ASSERT(translation != NULL);	// the TLB must not outlive the page
+    translation->use = tlbEntry->use;
+    if (tlbEntry->dirty)
+        translation->dirty = TRUE;
+    tlbEntry->valid = FALSE;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::FlushTLB
+// 	Copy the use and dirty bits of every entry in the TLB back into
+//	the page table, and empty the TLB.  Must be called before the
+//	page table is changed, and when the program stops running.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::FlushTLB()
+{
+    for (int i = 0; i < machine->tlbSize; i++)
+        SaveTLBEntry(i);
+    machine->FlushSoftTLB();
+}
+#endif
+
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
 // 	Set the initial values for the user-level register set.
@@ -224,24 +711,37 @@ AddrSpace::InitRegisters()
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	With a TLB, that is the use and dirty bits in it; otherwise,
+//	nothing!
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState() 
-{}
+{
+#ifdef USE_TLB
+    FlushTLB();
+#endif
+}
 
 //----------------------------------------------------------------------
 // AddrSpace::RestoreState
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table (or,
+//	with a TLB, empty it, to be refilled by PageFault), and have it
+//	forget translations it remembered from the last one.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    machine->pageTable = pageTable;
+#ifdef USE_TLB
+    for (int i = 0; i < machine->tlbSize; i++)
+        machine->tlb[i].valid = FALSE;
+#else
+    machine->pageTable = pageTable->Directory();
     machine->pageTableSize = numPages;
+#endif
+    machine->FlushSoftTLB();
 }
 
 //----------------------------------------------------------------------
@@ -253,13 +753,3 @@ unsigned int AddrSpace::getNumPages()
 {
     return numPages;
 }
-
-//----------------------------------------------------------------------
-// AddrSpace::getStartPhysPage
-// Return the num of virtual pages of the thread
-//----------------------------------------------------------------------
-
-unsigned int AddrSpace::getStartPhysPage() 
-{
-    return pageTable[0].physicalPage;
-}
@@ -15,22 +15,27 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "pagetable.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define UserVirtPages		32768	// pages in an address space, unless
+					// the program needs more; the stack
+					// is at the top
 
-// Stores the total no of pages which have been allocated as of yet
-extern int totalPagesCount;
+class Executable;			// where pages are loaded from
 
 class AddrSpace {
   public:
-    AddrSpace(OpenFile *executable);	// Create an address space,
+    AddrSpace(OpenFile *executable, char *name);
+					// Create an address space,
 					// initializing it with the program
-					// stored in the file "executable"
+					// stored in the file "executable",
+					// sharing its code by "name"
     
-    AddrSpace(unsigned int numParentPages, unsigned int parentStartPhysPage);	
+    AddrSpace(AddrSpace *parentSpace);	
                     // Create an address space,
-                    // create a page table, map it to memory
-                    // copy parents segment
+                    // create a page table, share the parent's
+                    // frames until either one writes to them
     ~AddrSpace();			// De-allocate an address space
 
     void InitRegisters();		// Initialize user-level CPU registers,
@@ -41,10 +46,44 @@ class AddrSpace {
     
     unsigned int getNumPages();  // returns the number of virtual pages in
                                     // address space
-    unsigned int getStartPhysPage(); // return the start address of the physical page
+    bool CopyOnWrite(int virtAddr); // give the page a frame of its own, if
+                                    // it is shared until written; returns
+                                    // FALSE if it is not
+    bool PageFault(int virtAddr);   // load the page, and/or its TLB entry;
+                                    // returns FALSE if it is not mapped
+#ifdef VM
+    void PageOut(unsigned int vpn);	// give up the page's frame, saving
+					// the page in swap if need be
+#endif
   private:
-    TranslationEntry *pageTable;	// Assume linear page table translation
-					// for now!
+    void LoadPage(unsigned int vpn);	// read in a page, from swap or the
+					// executable, or share cached text
+    void ReleaseProgram();		// done loading from the executable
+    TranslationEntry *Resident(unsigned int vpn);
+					// the page's translation, if it is
+					// in memory; else NULL
+    TranslationEntry *MapFrame(unsigned int vpn, int frame, bool readOnly);
+					// the page is now in "frame"
+    void UnmapFrame(unsigned int vpn);	// the page is no longer in memory
+    Executable *program;		// the file pages are read in from,
+					// or NULL once they all have been
+#ifdef VM
+    void CopySwapSlot(unsigned int vpn, int from);
+					// copy another space's swapped page
+#endif
+#ifdef USE_TLB
+    void LoadTLB(TranslationEntry *translation);
+					// refill the TLB after a miss
+    void SaveTLBEntry(int i);		// save an entry's use/dirty bits,
+					// and empty it
+    void FlushTLB();			// save use/dirty bits, empty the TLB
+#endif
+
+    PageTable *pageTable;		// two-level, with leaves only for
+					// the mapped pages; with a TLB,
+					// the translations of the pages in
+					// memory are in the inverted page
+					// table instead
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
 };
@@ -89,16 +89,23 @@ BitMap::Test(int which)
 //	(In other words, find and allocate a bit.)
 //
 //	If no bits are clear, return -1.
+//
+//	Words with every bit set are passed over without testing their
+//	bits one by one.
 //----------------------------------------------------------------------
 
 int 
 BitMap::Find() 
 {
-    for (int i = 0; i < numBits; i++)
-	if (!Test(i)) {
-	    Mark(i);
-	    return i;
-	}
+    for (int w = 0; w < numWords; w++) {
+	if (map[w] == ~0U)		// skip full words a word at a time
+	    continue;
+	for (int i = w * BitsInWord; i < numBits && i < (w + 1) * BitsInWord; i++)
+	    if (!Test(i)) {
+		Mark(i);
+		return i;
+	    }
+    }
     return -1;
 }
 
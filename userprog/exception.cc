@@ -1,386 +1,543 @@
-// exception.cc 
+// exception.cc
 //	Entry point into the Nachos kernel from user programs.
 //	There are two kinds of things that can cause control to
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  Each system call code (see syscall.h) has
+//	a handler in "syscallTable".
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
-//	etc.  
+//	etc.
 //
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Page faults and writes to pages shared copy-on-write are handled;
+// everything else core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
-#include "console.h"
-#include "synch.h"
+#include "synchconsole.h"
+#include "usermem.h"
+
+#define MaxExecName	256		// longest file name Exec takes
+
+// The console the system calls print on.  It is created the first time
+// a program prints, and shared by every program after that.
+
+static SynchConsole *console = NULL;
 
 //----------------------------------------------------------------------
-// ExceptionHandler
-// 	Entry point into the Nachos kernel.  Called when a user program
-//	is executing, and either does a syscall, or generates an addressing
-//	or arithmetic exception.
-//
-// 	For system calls, the following is the calling convention:
-//
-// 	system call code -- r2
-//		arg1 -- r4
-//		arg2 -- r5
-//		arg3 -- r6
-//		arg4 -- r7
-//
-//	The result of the system call, if any, must be put back into r2. 
-//
-// And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
-//
-//	"which" is the kind of exception.  The list of possible exceptions 
-//	are in machine.h.
+// OpenConsole
+// 	Return the console, creating it if no program has used it yet.
 //----------------------------------------------------------------------
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
 
-    void
-ExceptionHandler(ExceptionType which)
+static SynchConsole *
+OpenConsole()
 {
-    int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
+    if (console == NULL)
+        console = new SynchConsole(NULL, NULL);
+    return console;
+}
 
-    // New changes
-    if (!initializedConsoleSemaphores) {
-        readAvail = new Semaphore("read avail", 0);
-        writeDone = new Semaphore("write done", 1);
-        initializedConsoleSemaphores = true;
-    }
+//----------------------------------------------------------------------
+// WriteConsole
+// 	Queue "size" characters from "buffer" for the console.
+//----------------------------------------------------------------------
 
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);;
+static void
+WriteConsole(char *buffer, int size)
+{
+    OpenConsole()->Write(buffer, size);
+}
 
-    if ((which == SyscallException) && (type == SC_Halt)) {
-        DEBUG('a', "Shutdown, initiated by user program.\n");
-        interrupt->Halt();
-    }
-    else if ((which == SyscallException) && (type == SC_PrintInt)) {
-        printval = machine->ReadRegister(4);
-        if (printval == 0) {
-            writeDone->P() ;
-            console->PutChar('0');
-        }
-        else {
-            if (printval < 0) {
-                writeDone->P() ;
-                console->PutChar('-');
-                printval = -printval;
-            }
-            tempval = printval;
-            exp=1;
-            while (tempval != 0) {
-                tempval = tempval/10;
-                exp = exp*10;
-            }
-            exp = exp/10;
-            while (exp > 0) {
-                writeDone->P() ;
-                console->PutChar('0'+(printval/exp));
-                printval = printval % exp;
-                exp = exp/10;
-            }
-        }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SC_PrintChar)) {
-        writeDone->P() ;
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+//----------------------------------------------------------------------
+// FlushConsole
+// 	Wait for everything the programs have printed to reach the
+//	display, before halting.
+//----------------------------------------------------------------------
+
+static void
+FlushConsole()
+{
+    if (console != NULL)
+        console->Flush();
+}
+
+//----------------------------------------------------------------------
+// System call handlers
+// 	Each is called with the system call's arguments, from r4 to r7,
+//	and returns its result, which ExceptionHandler puts in r2.  The
+//	program counters have already been moved past the syscall, so a
+//	handler can put the thread to sleep (or copy its registers) and
+//	it will go on from the right place.
+//----------------------------------------------------------------------
+
+static int
+SysHalt(int arg1, int arg2, int arg3, int arg4)
+{
+    DEBUG('a', "Shutdown, initiated by user program.\n");
+    FlushConsole();
+    interrupt->Halt();
+    return 0;				// not reached
+}
+
+static int
+SysPrintInt(int printval, int arg2, int arg3, int arg4)
+{
+    char buffer[12];			// enough for "-2147483648"
+
+    sprintf(buffer, "%d", printval);
+    WriteConsole(buffer, strlen(buffer));
+    return 0;
+}
+
+static int
+SysPrintChar(int ch, int arg2, int arg3, int arg4)
+{
+    char c = ch;
+
+    WriteConsole(&c, 1);   // echo it!
+    return 0;
+}
+
+static int
+SysPrintString(int vaddr, int arg2, int arg3, int arg4)
+{
+    char buffer[PageSize];
+    char *end;
+    int chunk;
+
+    // copy the string in a page at a time, up to the null
+    do {
+        chunk = PageSize - (unsigned) vaddr % PageSize;
+        if (!CopyIn(vaddr, buffer, chunk))
+            return -1;
+        end = (char *) memchr(buffer, '\0', chunk);
+        if (end != NULL)
+            chunk = end - buffer;
+        if (chunk > 0)
+            WriteConsole(buffer, chunk);
+        vaddr += chunk;
+    } while (end == NULL);
+    return 0;
+}
+
+static int
+SysWrite(int vaddr, int size, int id, int arg4)
+{
+    char buffer[PageSize];
+    int chunk, done;
+
+    // only the console can be written to
+    if ((id != ConsoleOutput) || (size < 0))
+        return -1;
+    for (done = 0; done < size; done += chunk) {
+        chunk = min(size - done, PageSize);
+        if (!CopyIn(vaddr + done, buffer, chunk))
+            return -1;
+        WriteConsole(buffer, chunk);
     }
-    else if ((which == SyscallException) && (type == SC_PrintString)) {
-        vaddr = machine->ReadRegister(4);
-        machine->ReadMem(vaddr, 1, &memval);
-        while ((*(char*)&memval) != '\0') {
-            writeDone->P() ;        // wait for write to finish
-            console->PutChar(*(char*)&memval);
-            vaddr++;
-            machine->ReadMem(vaddr, 1, &memval);
-        }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } 
-    else if ((which == SyscallException) && (type == SC_GetReg)) {
-        int reg = (int) machine->ReadRegister(4);
-        reg = (int) machine->ReadRegister(reg);
-        machine->WriteRegister(2, reg);
+    return size;
+}
 
-        // Advance program counters
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+static int
+SysRead(int vaddr, int size, int id, int arg4)
+{
+    char buffer[ConsoleBufferSize];
+    int count;
+
+    // only the console can be read from; each Read returns at most
+    // one line, so one buffer's worth is always enough
+    if ((id != ConsoleInput) || (size < 0))
+        return -1;
+    count = OpenConsole()->Read(buffer, min(size, ConsoleBufferSize));
+    if (!CopyOut(buffer, vaddr, count))
+        return -1;
+    return count;
+}
+
+static int
+SysGetReg(int reg, int arg2, int arg3, int arg4)
+{
+    return machine->ReadRegister(reg);
+}
+
+static int
+SysGetPA(int virtAddress, int arg2, int arg3, int arg4)
+{
+    unsigned vpn = (unsigned) virtAddress/PageSize;
+    int physAddress;
+    TranslationEntry *leaf = NULL;
+
+    // Checking conditions
+    if ((machine->pageTable != NULL) && (vpn < machine->pageTableSize))
+        leaf = machine->pageTable[vpn >> LeafBits];
+    if (leaf == NULL) {
+        physAddress = -1;
+    } else if (!leaf[vpn % LeafSize].valid) {
+        physAddress = -1;
+    } else if (leaf[vpn % LeafSize].physicalPage > NumPhysPages ){
+        physAddress = -1;
+    } else {
+        machine->Translate(virtAddress, &physAddress, 4, FALSE);
     }
-    else if ((which == SyscallException) && (type == SC_GetPA)) {
-        int virtAddress = machine->ReadRegister(4);
-        unsigned vpn = (unsigned) virtAddress/PageSize;
-        int physAddress;
-
-        // Checking conditions
-        if(vpn > machine->pageTableSize) {
-            physAddress = -1;
-        } else if (!machine->pageTable[vpn].valid) {
-            physAddress = -1;
-        } else if (machine->pageTable[vpn].physicalPage > NumPhysPages ){
-            physAddress = -1;
-        } else {
-            machine->Translate(virtAddress, &physAddress, 4, FALSE);
-        }
-        machine->WriteRegister(2, (unsigned)physAddress);
+    return physAddress;
+}
 
-        // Advance program counters
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } 
-    else if ((which == SyscallException) && (type == SC_GetPID)) {
-        machine->WriteRegister(2, currentThread->getPid());
+static int
+SysGetPID(int arg1, int arg2, int arg3, int arg4)
+{
+    return currentThread->getPid();
+}
 
-        // Advance program counters
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } 
-    else if ((which == SyscallException) && (type == SC_GetPPID)) {
-        machine->WriteRegister(2, currentThread->getPpid());
+static int
+SysGetPPID(int arg1, int arg2, int arg3, int arg4)
+{
+    return currentThread->getPpid();
+}
 
-        // Advance program counters
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } 
-    else if ((which == SyscallException) && (type == SC_Time)) {
-        // this is a simple system call, just acces the global variable
-        // totalTicks
-        machine->WriteRegister(2, stats->totalTicks);
+static int
+SysTime(int arg1, int arg2, int arg3, int arg4)
+{
+    // this is a simple system call, just acces the global variable
+    // totalTicks
+    return stats->totalTicks;
+}
 
-        // Advance program counters
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } 
-    else if ((which == SyscallException) && (type == SC_Yield)) {
-        // Increase the program counter before yielding
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+static int
+SysYield(int arg1, int arg2, int arg3, int arg4)
+{
+    // Call yield method on the current thread
+    currentThread->Yield();
+    return 0;
+}
 
-        // Call yield method on the current thread
+static int
+SysSleep(int time, int arg2, int arg3, int arg4)
+{
+    // "time" is in number of ticks.  Yield if time is zero, or else put
+    // the thread on the timerQueue, and make sure the timer will be
+    // there to wake it up
+    if (time == 0) {
+        IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
         currentThread->Yield();
-    } 
-    else if ((which == SyscallException) && (type == SC_Sleep)) {
-        // Increase the program counter before sleeping 
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+        (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+    } else {
+        timerQueue->Insert((void *)currentThread, stats->totalTicks + time);
+        timer->WakeBy(stats->totalTicks + time);
+        // Sleep the current Process
+        IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+        currentThread->Sleep();
+        (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+    }
+    return 0;
+}
 
-        // The time in number of ticks
-        int time = machine->ReadRegister(4);
+static int
+SysSetPriority(int pid, int priority, int arg3, int arg4)
+{
+    Thread *thread = (pid == 0) ? currentThread : Thread::Lookup(pid);
+    int old;
+
+    if ((thread == NULL) || (priority < 0) || (priority >= NumPriorities))
+        return -1;
+    old = thread->basePriority;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    scheduler->SetPriority(thread, priority);
+    (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+    return old;
+}
 
-        // Yield if time is zero, or else insert the element in a sorted fashion
-        // into the timerQueue
-        if (time == 0) {
-            IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-            currentThread->Yield();
-            (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
-        } else {
-            timerQueue->SortedInsert((void *)currentThread, stats->totalTicks + time);  
-            // Sleep the current Process
-            IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-            currentThread->Sleep();
-            (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
-        }
-    } 
-    else if ((which == SyscallException) && (type == SC_Fork)) {
-        // Increase the program counter before sleeping 
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+static int
+SysFork(int arg1, int arg2, int arg3, int arg4)
+{
+    // create a new kernel thread
+    Thread *child = new Thread("forked thread");
 
-        // create a new kernel thread
-        Thread *child = new Thread("forked thread");
+    // Set the parent of the child process
+    child->parent = currentThread;
 
-        // Set the parent of the child process
-        child->parent = currentThread;
+    // Add the child to the parent's list
+    currentThread->initializeChildStatus(child->getPid());
 
-        // Add the child to the parent's list
-        currentThread->initializeChildStatus(child->getPid());
+    // Copy the address space of the currentThread into the child thread
+    child->space = new AddrSpace(currentThread->space);
 
-        // Copy the address space of the currentThread into the child thread
-        // child->space = currentThread->space;
-        child->space = new AddrSpace(currentThread->space->getNumPages(), currentThread->space->getStartPhysPage()); 
+    // Change the return address register to zero and save state
+    machine->WriteRegister(2, 0);
+    child->SaveUserState();
 
-        // Change the return address register to zero and save state
-        machine->WriteRegister(2, 0);
-        child->SaveUserState();
+    // Allocate the stack
+    child->StackAllocate(&forkStart, 0);
 
-        // Setting the return value of the parent thread
-        machine->WriteRegister(2, child->getPid());
+    // The child is now ready to run
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    scheduler->ReadyToRun(child);
+    (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 
-        // Allocate the stack 
-        child->StackAllocate(&forkStart, 0);
+    // The parent gets the child's pid
+    return child->getPid();
+}
 
-        // The child is now ready to run
-        IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-        scheduler->ReadyToRun(child);
-        (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+static int
+SysExec(int vaddr, int arg2, int arg3, int arg4)
+{
+    // We are in the kernel space, we have to copy the name of the file
+    // in from the program's memory
+    char filename[MaxExecName];
+    int length = CopyInString(vaddr, filename, MaxExecName);
+
+    if (length < 0) {			// unreadable, or too long
+        printf("Bad file name for Exec\n");
+        return -1;
+    }
+
+    // What follows is a direct copy of StartProcess, I didn't want to change
+    // its scope so it has been included here
+    OpenFile *executable = fileSystem->Open(filename);
+    AddrSpace *space;
+
+    if (executable == NULL) {
+        printf("Unable to open file %s\n", filename);
+        return -1;
     }
-    else if ((which == SyscallException) && (type == SC_Exec)) {
-        // We are in the kernel space, we have to copy the name of the file 
-        // by translating using ReadMem
-        char filename[100];
-        int i=0;
-
-        vaddr = machine->ReadRegister(4);
-        machine->ReadMem(vaddr, 1, &memval);
-        while ((*(char*)&memval) != '\0') {
-            filename[i]  = (char)memval;
-            ++i;
-            vaddr++;
-            machine->ReadMem(vaddr, 1, &memval);
+    delete currentThread->space;	// give its frames back first
+    space = new AddrSpace(executable, filename);
+    currentThread->space = space;
+
+#ifndef VM
+    delete executable;			// close file
+#endif					// (else the space loads from it)
+
+    space->InitRegisters();		// set the initial register values
+    scheduler->LoadSpace();		// load page table register
+
+    machine->Run();			// jump to the user progam
+    ASSERT(FALSE);			// machine->Run never returns;
+    // the address space exits
+    // by doing the syscall "exit"
+    return 0;
+}
+
+static int
+SysJoin(int pid, int arg2, int arg3, int arg4)
+{
+    DEBUG('J', "Joining %d with %d\n", currentThread->getPid(), pid);
+
+    // Search whether the child is present in the list or not,
+    // after we have searched for the pid, we check if the child is live or
+    // not, if it is not live then we sleep the thread or else we just
+    // return the exit status of the child directly
+    int childStatus = currentThread->getChildStatus(pid);
+
+    if(childStatus!= CHILD_NOT_FOUND) {
+        // The very first time, the child is live, we set the status as
+        // parent waiting and send the thread to sleep, if it wakes and
+        // the status is still PARENT_WAITING, we send it to sleep
+        if(childStatus == CHILD_LIVE) {
+            DEBUG('J', "Child %d was live: Parent %d\n", pid, currentThread->getPid());
+            currentThread->setChildStatus(pid, PARENT_WAITING);
+
+            // Send the thread to sleep
+            IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+            currentThread->Sleep();
+            (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
         }
-        filename[i]  = (char)memval;
 
-        // The above is a direct copy of StartProcess, I didn't want to change
-        // its scope so it has been included here
-        OpenFile *executable = fileSystem->Open(filename);
-        AddrSpace *space;
+        // The status of the thread may have changed when we come over here,
+        // so we obtain it again
+        childStatus = currentThread->getChildStatus(pid);
+        while(childStatus == PARENT_WAITING) {
+            // Sleep the thread
+            DEBUG('J', "Parent %d  was sleeping: child %d\n", currentThread->getPid(), pid);
 
-        if (executable == NULL) {
-            printf("Unable to open file %s\n", filename);
-            return;
+            IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+            currentThread->Sleep();
+            (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+
+            // Obtain the new status
+            childStatus = currentThread->getChildStatus(pid);
         }
-        space = new AddrSpace(executable);    
-        currentThread->space = space;
 
-        delete executable;			// close file
+        // The child has exited, and its status is collected now
+        currentThread->removeChildStatus(pid);
+    }
+
+    DEBUG('J', "Parent %d's child %d's state %d\n", currentThread->getPid(), pid, childStatus);
+    return childStatus;
+}
 
-        space->InitRegisters();		// set the initial register values
-        space->RestoreState();		// load page table register
+static int
+SysExit(int exitStatus, int arg2, int arg3, int arg4)
+{
+    DEBUG('t', "Exist Status of %d is %d\n", currentThread->getPid(), exitStatus);
 
-        machine->Run();			// jump to the user progam
-        ASSERT(FALSE);			// machine->Run never returns;
-        // the address space exits
-        // by doing the syscall "exit"
+    // Note here that the exit status of the child cannot be CHILD_LIVE
+    // or PARENT_WAITING, in such a case we set the return status to 0
+    if(exitStatus == CHILD_LIVE || exitStatus == PARENT_WAITING) {
+        exitStatus = 0;
     }
-    else if ((which == SyscallException) && (type == SC_Join)) {
-        int pid = machine->ReadRegister(4);
-        DEBUG('J', "Joining %d with %d\n", currentThread->getPid(), pid);
-
-        // Search whether the child is present in the list or not,
-        // after we have searched for the pid, we check if the child is live or
-        // not, if it is not live then we sleep the thread or else we just
-        // return the exit status of the child directly
-        int childStatus = currentThread->getChildStatus(pid);
-
-        if(childStatus!= CHILD_NOT_FOUND) {
-            // The very first time, the child is live, we set the status as
-            // parent waiting and send the thread to sleep, if it wakes and
-            // the status is still PARENT_WAITING, we send it to sleep
-            if(childStatus == CHILD_LIVE) {
-                DEBUG('J', "Child %d was live: Parent %d\n", pid, currentThread->getPid());
-                currentThread->setChildStatus(pid, PARENT_WAITING);
-
-                // Send the thread to sleep
-                IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-                currentThread->Sleep();
-                (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
-            }
-            
-            // The status of the thread may have changed when we come over here,
-            // so we obtain it again
-            childStatus = currentThread->getChildStatus(pid);
-            while(childStatus == PARENT_WAITING) {
-                // Sleep the thread
-                DEBUG('J', "Parent %d  was sleeping: child %d\n", currentThread->getPid(), pid);
 
-                IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-                currentThread->Sleep();
-                (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
+    // Now the child has to set it's status to its exit status, and make it
+    // ready to be destroyed, all of this must be atomic so we turn off all
+    // interrupts, also we have to wake up the parent
 
-                // Obtain the new status
-                childStatus = currentThread->getChildStatus(pid);
-            }
+    // Stop the machine if this is the only thread
+    if(Thread::threadCount == 1) {
+        DEBUG('t', "No more threads left, halting machine\n");
+        FlushConsole();
+        interrupt->Halt();
+    }
+
+    // If parent is alive, signal the parent
+    if(currentThread->parent != NULL) {
+        // If the parent was waiting for this child thread then make it
+        // ready to run
+        DEBUG('c', "parent of %d exists, will kill it\n", currentThread->getPid());
+        int flag = currentThread->parent->getChildStatus(currentThread->getPid());
+
+        // Set the return status of the child
+        currentThread->parent->setChildStatus(currentThread->getPid(), exitStatus);
+
+        // If parent was waiting for the thread
+        if(flag == PARENT_WAITING) {
+            // The parent is now ready to run
+            IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+            scheduler->ReadyToRun(currentThread->parent);
+            (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
         }
+    }
+
+    // Finish the current thread
+    currentThread->Finish();
+    return 0;				// not reached
+}
+
+// The system calls, indexed by their codes in syscall.h, with how many
+// times each has been made.  Codes with no handler are not supported.
+
+class SyscallEntry {
+  public:
+    char *name;				// for printing
+    int (*handler)(int arg1, int arg2, int arg3, int arg4);
+    int count;				// calls so far
+};
+
+static SyscallEntry syscallTable[] = {
+    { "Halt", SysHalt, 0 },		// SC_Halt
+    { "Exit", SysExit, 0 },		// SC_Exit
+    { "Exec", SysExec, 0 },		// SC_Exec
+    { "Join", SysJoin, 0 },		// SC_Join
+    { "Create", NULL, 0 },		// SC_Create
+    { "Open", NULL, 0 },		// SC_Open
+    { "Read", SysRead, 0 },		// SC_Read
+    { "Write", SysWrite, 0 },		// SC_Write
+    { "Close", NULL, 0 },		// SC_Close
+    { "Fork", SysFork, 0 },		// SC_Fork
+    { "Yield", SysYield, 0 },		// SC_Yield
+    { "PrintInt", SysPrintInt, 0 },	// SC_PrintInt
+    { "PrintChar", SysPrintChar, 0 },	// SC_PrintChar
+    { "PrintString", SysPrintString, 0 },	// SC_PrintString
+    { "GetReg", SysGetReg, 0 },		// SC_GetReg
+    { "GetPA", SysGetPA, 0 },		// SC_GetPA
+    { "GetPID", SysGetPID, 0 },		// SC_GetPID
+    { "GetPPID", SysGetPPID, 0 },	// SC_GetPPID
+    { "Sleep", SysSleep, 0 },		// SC_Sleep
+    { "Time", SysTime, 0 },		// SC_Time
+    { "SetPriority", SysSetPriority, 0 },	// SC_SetPriority
+};
+
+#define NumSyscalls	((int) (sizeof(syscallTable) / sizeof(SyscallEntry)))
+
+//----------------------------------------------------------------------
+// ExceptionHandler
+// 	Entry point into the Nachos kernel.  Called when a user program
+//	is executing, and either does a syscall, or generates an addressing
+//	or arithmetic exception.
+//
+// 	For system calls, the following is the calling convention:
+//
+// 	system call code -- r2
+//		arg1 -- r4
+//		arg2 -- r5
+//		arg3 -- r6
+//		arg4 -- r7
+//
+//	The result of the system call, if any, must be put back into r2.
+//
+// And don't forget to increment the pc before returning. (Or else you'll
+// loop making the same system call forever!)  That is done here, for
+// every system call, before its handler runs.
+//
+//	"which" is the kind of exception.  The list of possible exceptions
+//	are in machine.h.
+//----------------------------------------------------------------------
 
-        // Set the return value
-        DEBUG('J', "Parent %d's child %d's state %d\n", currentThread->getPid(), pid, childStatus);
-        machine->WriteRegister(2, childStatus);
+void
+ExceptionHandler(ExceptionType which)
+{
+    int type = machine->ReadRegister(2);
+    SyscallEntry *call;
+    int result;
 
-        // Increase the program counter after setting child Status
+    if ((which == SyscallException) && (type >= 0) && (type < NumSyscalls)
+            && (syscallTable[type].handler != NULL)) {
+        call = &syscallTable[type];
+        call->count++;
+
+        // Advance program counters.
         machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
         machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
         machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SC_Exit)) {
-        int exitStatus = machine->ReadRegister(4);
-        DEBUG('t', "Exist Status of %d is %d\n", currentThread->getPid(), exitStatus);
-
-        // Note here that the exit status of the child cannot be CHILD_LIVE
-        // or PARENT_WAITING, in such a case we set the return status to 0
-        if(exitStatus == CHILD_LIVE || exitStatus == PARENT_WAITING) {
-            exitStatus = 0;
-        }
-
-        // Now the child has to set it's status to its exit status, and make it
-        // ready to be destroyed, all of this must be atomic so we turn off all
-        // interrupts, also we have to wake up the parent
-        
-        // Stop the machine if this is the only thread
-        if(Thread::threadCount == 1) {
-            DEBUG('t', "No more threads left, halting machine\n");
-            interrupt->Halt();
-        }
 
-        // If parent is alive, signal the parent
-        if(currentThread->parent != NULL) {
-            // If the parent was waiting for this child thread then make it
-            // ready to run
-            DEBUG('c', "parent of %d exists, will kill it\n", currentThread->getPid());
-            int flag = currentThread->parent->getChildStatus(currentThread->getPid());
-            
-            // Set the return status of the child
-            currentThread->parent->setChildStatus(currentThread->getPid(), exitStatus);
-           
-            // If parent was waiting for the thread
-            if(flag == PARENT_WAITING) {
-                // The parent is now ready to run
-                IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-                scheduler->ReadyToRun(currentThread->parent);
-                (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
-            }
-        }
-
-        // Finish the current thread
-        currentThread->Finish();
+        result = (*call->handler)(machine->ReadRegister(4),
+                machine->ReadRegister(5), machine->ReadRegister(6),
+                machine->ReadRegister(7));
+        machine->WriteRegister(2, result);
+    }
+    else if ((which == ReadOnlyException) &&
+            currentThread->space->CopyOnWrite(machine->ReadRegister(BadVAddrReg))) {
+        // The page was shared with a parent or child; it now has a
+        // copy of its own.  The program counters have not moved, so
+        // the store is simply tried again.
+        DEBUG('a', "Copied page at 0x%x on write\n", machine->ReadRegister(BadVAddrReg));
+    }
+    else if ((which == PageFaultException) &&
+            currentThread->space->PageFault(machine->ReadRegister(BadVAddrReg))) {
+        // The page has been loaded, or put in the TLB; the faulting
+        // instruction is simply run again
     }
     else {
         printf("Unexpected user mode exception %d %d\n", which, type);
         ASSERT(FALSE);
     }
 }
+
+//----------------------------------------------------------------------
+// PrintSyscallCounts
+// 	Print how many times each system call has been made, when Nachos
+//	shuts down.  Calls never made are left out.
+//----------------------------------------------------------------------
+
+void
+PrintSyscallCounts()
+{
+    bool any = FALSE;
+
+    for (int i = 0; i < NumSyscalls; i++)
+        if (syscallTable[i].count > 0) {
+            printf("%s%s %d", any ? ", " : "System calls: ",
+                    syscallTable[i].name, syscallTable[i].count);
+            any = TRUE;
+        }
+    if (any)
+        printf("\n");
+}
@@ -0,0 +1,172 @@
+// pagetable.cc
+//	Routines to manage an address space's two-level page table.
+//
+//	An allocated leaf may have pages that are not mapped; they may be
+//	mapped later, one region at a time.  Such a page's translation
+//	entry is invalid, since the hardware looks only at "valid".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagetable.h"
+
+//----------------------------------------------------------------------
+// PageTable::PageTable
+// 	Initialize a page table for an address space of "size" pages.
+//	Only the directory is allocated; no page is mapped yet.
+//----------------------------------------------------------------------
+
+PageTable::PageTable(unsigned int size)
+{
+    numPages = size;
+    directorySize = divRoundUp(size, LeafSize);
+    numLeaves = 0;
+#ifndef USE_TLB
+    directory = new TranslationEntry *[directorySize];
+#endif
+    info = new PageInfo *[directorySize];
+    for (int i = 0; i < directorySize; i++) {
+#ifndef USE_TLB
+	directory[i] = NULL;
+#endif
+	info[i] = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// PageTable::~PageTable
+// 	De-allocate the directory and every leaf.
+//----------------------------------------------------------------------
+
+PageTable::~PageTable()
+{
+    for (int i = 0; i < directorySize; i++) {
+#ifndef USE_TLB
+	delete [] directory[i];
+#endif
+	delete [] info[i];
+    }
+#ifndef USE_TLB
+    delete [] directory;
+#endif
+    delete [] info;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Map
+// 	Map the "count" pages starting at "first", allocating the leaves
+//	they are in.  Each page is not in memory (its translation entry,
+//	if the table has them, is invalid), holds no code, is not shared,
+//	and is not in swap.
+//----------------------------------------------------------------------
+
+void
+PageTable::Map(unsigned int first, unsigned int count)
+{
+    unsigned int vpn;
+    int leaf, i;
+    PageInfo *page;
+#ifndef USE_TLB
+    TranslationEntry *entry;
+#endif
+
+    ASSERT(first + count <= numPages);
+    for (vpn = first; vpn < first + count; vpn++) {
+	leaf = vpn >> LeafBits;
+	if (info[leaf] == NULL) {
+	    info[leaf] = new PageInfo[LeafSize];
+	    for (i = 0; i < LeafSize; i++)
+		info[leaf][i].mapped = FALSE;
+#ifndef USE_TLB
+	    directory[leaf] = new TranslationEntry[LeafSize];
+	    for (i = 0; i < LeafSize; i++) {
+		entry = &directory[leaf][i];
+		entry->virtualPage = LeafSize * leaf + i;
+		entry->physicalPage = -1;
+		entry->valid = FALSE;
+		entry->readOnly = FALSE;
+		entry->use = FALSE;
+		entry->dirty = FALSE;
+	    }
+#endif
+	    numLeaves++;
+	}
+	page = &info[leaf][vpn % LeafSize];
+	page->mapped = TRUE;
+	page->text = FALSE;
+	page->shared = FALSE;
+#ifdef VM
+	page->swapSlot = -1;
+#endif
+    }
+}
+
+//----------------------------------------------------------------------
+// PageTable::IsMapped
+// 	Return TRUE if page "vpn" is in the address space.
+//----------------------------------------------------------------------
+
+bool
+PageTable::IsMapped(unsigned int vpn)
+{
+    PageInfo *leaf;
+
+    if (vpn >= numPages)
+	return FALSE;
+    leaf = info[vpn >> LeafBits];
+    return (leaf != NULL) && leaf[vpn % LeafSize].mapped;
+}
+
+#ifndef USE_TLB
+//----------------------------------------------------------------------
+// PageTable::Entry
+// 	Return the translation entry for page "vpn", or NULL if the page
+//	is not mapped.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Entry(unsigned int vpn)
+{
+    if (!IsMapped(vpn))
+	return NULL;
+    return &directory[vpn >> LeafBits][vpn % LeafSize];
+}
+#endif
+
+//----------------------------------------------------------------------
+// PageTable::Info
+// 	Return what the kernel knows about page "vpn", which must be
+//	mapped.
+//----------------------------------------------------------------------
+
+PageInfo *
+PageTable::Info(unsigned int vpn)
+{
+    ASSERT(IsMapped(vpn));
+    return &info[vpn >> LeafBits][vpn % LeafSize];
+}
+
+//----------------------------------------------------------------------
+// PageTable::NextMapped
+// 	Return the first mapped page at or after "vpn", skipping whole
+//	leaves that are not allocated; Size() if there are no more.
+//	Lets the kernel visit every mapped page:
+//
+//	for (vpn = NextMapped(0); vpn < Size(); vpn = NextMapped(vpn + 1))
+//----------------------------------------------------------------------
+
+unsigned int
+PageTable::NextMapped(unsigned int vpn)
+{
+    while (vpn < numPages) {
+	if (info[vpn >> LeafBits] == NULL)
+	    vpn = ((vpn >> LeafBits) + 1) << LeafBits;
+	else if (!IsMapped(vpn))
+	    vpn++;
+	else
+	    return vpn;
+    }
+    return numPages;
+}
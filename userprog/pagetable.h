@@ -0,0 +1,83 @@
+// pagetable.h
+//	Data structures for an address space's page table, in two levels
+//	(see translate.h).  Leaves are allocated only for the regions of
+//	the address space that are mapped, so a large address space with
+//	its code and data at one end and its stack at the other costs
+//	little more than a small one.
+//
+//	Alongside each leaf of translation entries, the kernel keeps its
+//	own information about the same pages, which the machine never
+//	sees.  With a TLB, the machine never sees the table at all: the
+//	translations of the pages in memory are kept in the inverted page
+//	table (see ipt.h), and the leaves hold only the kernel's
+//	information.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include "copyright.h"
+#include "translate.h"
+
+// The following class defines what the kernel knows about a page,
+// besides its translation.
+
+class PageInfo {
+  public:
+    bool mapped;		// FALSE if the page is not in the address
+				// space
+    bool text;			// TRUE if the page holds nothing but
+				// code: it is read-only, and shares its
+				// frame with every address space running
+				// the same program
+    bool shared;		// TRUE if the page shares its frame until
+				// it is written
+#ifdef VM
+    int swapSlot;		// where the page is in swap, or -1
+#endif
+};
+
+// The following class defines a two-level page table.
+
+class PageTable {
+  public:
+    PageTable(unsigned int size);	// Initialize a table for "size"
+					// pages, none of them mapped
+    ~PageTable();			// De-allocate the table
+
+    void Map(unsigned int first, unsigned int count);
+					// Map "count" pages from "first",
+					// none of them in memory
+    bool IsMapped(unsigned int vpn);	// Is page "vpn" in the address space?
+    PageInfo *Info(unsigned int vpn);	// Return the kernel's information
+					// about page "vpn"; it must be mapped
+    unsigned int NextMapped(unsigned int vpn);
+					// Return the first mapped page from
+					// "vpn" on, or Size() if there is none
+#ifndef USE_TLB
+    TranslationEntry *Entry(unsigned int vpn);
+					// Return the entry for page "vpn",
+					// or NULL if it is not mapped
+
+    TranslationEntry **Directory() { return directory; }
+					// The table, for the machine
+#endif
+    unsigned int Size() { return numPages; }
+    int NumLeaves() { return numLeaves; }
+
+  private:
+    unsigned int numPages;		// pages the table covers
+    int directorySize;			// leaves it can have
+    int numLeaves;			// leaves allocated so far
+#ifndef USE_TLB
+    TranslationEntry **directory;	// each leaf of translation entries,
+					// or NULL
+#endif
+    PageInfo **info;			// the kernel's information for each
+					// leaf, or NULL
+};
+
+#endif // PAGETABLE_H
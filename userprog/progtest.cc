@@ -30,13 +30,15 @@ StartProcess(char *filename)
 	printf("Unable to open file %s\n", filename);
 	return;
     }
-    space = new AddrSpace(executable);    
+    space = new AddrSpace(executable, filename);    
     currentThread->space = space;
 
+#ifndef VM
     delete executable;			// close file
+#endif					// (else the space loads from it)
 
     space->InitRegisters();		// set the initial register values
-    space->RestoreState();		// load page table register
+    scheduler->LoadSpace();		// load page table register
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
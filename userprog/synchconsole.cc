@@ -0,0 +1,250 @@
+// synchconsole.cc
+//	Routines for the kernel's console driver.  See synchconsole.h.
+//
+//	The ring buffer is shared with the display interrupt handler, so
+//	it is only changed with interrupts off.  Threads waiting for
+//	room in it, or for it to empty, sleep on "outputDone" and check
+//	again each time a burst goes out.  The same goes for the input
+//	ring buffer, which the keyboard interrupt handler fills.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchconsole.h"
+#include "system.h"
+
+// Dummy functions because C++ can't handle pointers to member functions
+static void ConsoleWriteDone(int c)
+{ SynchConsole *console = (SynchConsole *)c; console->WriteDone(); }
+static void ConsoleReadAvail(int c)
+{ SynchConsole *console = (SynchConsole *)c; console->ReadAvail(); }
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the console driver, and the device under it.
+//
+//	"readFile", "writeFile" -- UNIX files for the keyboard and
+//		display (NULL for stdin and stdout)
+//----------------------------------------------------------------------
+
+SynchConsole::SynchConsole(char *readFile, char *writeFile)
+{
+    writer = new Semaphore("console writer", 1);
+    outputDone = new Semaphore("console output done", 0);
+    numWaiting = 0;
+    reader = new Semaphore("console reader", 1);
+    lineAvail = new Semaphore("console line avail", 0);
+    readWaiting = FALSE;
+    outHead = outCount = outBusy = 0;
+    inHead = inCount = inLine = inEndOfFile = 0;
+    inputEnded = FALSE;
+    console = new Console(readFile, writeFile, ConsoleReadAvail,
+				ConsoleWriteDone, (int) this);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate the console driver.  Anything still in the ring
+//	buffer is lost; call Flush first to keep it.
+//----------------------------------------------------------------------
+
+SynchConsole::~SynchConsole()
+{
+    delete console;
+    delete lineAvail;
+    delete reader;
+    delete outputDone;
+    delete writer;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Write
+// 	Copy characters into the ring buffer, starting the display on
+//	them if it is idle.  We only wait if the ring buffer is full.
+//
+//	"buffer" -- the characters to write
+//	"size" -- how many there are
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Write(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int tail, count;
+
+    writer->P();
+    oldLevel = interrupt->SetLevel(IntOff);
+    while (size > 0) {
+	while (outCount == ConsoleBufferSize)
+	    WaitForOutput();
+	tail = (outHead + outCount) % ConsoleBufferSize;
+	count = min(size, ConsoleBufferSize - outCount);
+	count = min(count, ConsoleBufferSize - tail);
+	bcopy(buffer, &outBuffer[tail], count);
+	outCount += count;
+	buffer += count;
+	size -= count;
+	if (outBusy == 0)
+	    StartOutput();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    writer->V();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Flush
+// 	Wait for the display to put everything in the ring buffer.
+//	Called before halting, so that no output is lost.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Flush()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while (outCount > 0)
+	WaitForOutput();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WriteDone
+// 	The display has put the last burst.  Take it out of the ring
+//	buffer, start the next one, and wake up anyone waiting.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::WriteDone()
+{
+    outHead = (outHead + outBusy) % ConsoleBufferSize;
+    outCount -= outBusy;
+    outBusy = 0;
+    if (outCount > 0)
+	StartOutput();
+    for (; numWaiting > 0; numWaiting--)
+	outputDone->V();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Read
+// 	Wait until a whole line has been typed, then copy it out, up to
+//	and including its newline, or "size" characters, whichever is
+//	less; the rest of the line is left for the next Read.
+//
+//	Returns how many characters were copied, or 0 for a ^D typed at
+//	the start of a line, or once the input has run out.
+//
+//	"buffer" -- where to put the characters
+//	"size" -- the most to return
+//----------------------------------------------------------------------
+
+int
+SynchConsole::Read(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int count = 0;
+    char ch;
+
+    if (size <= 0)
+	return 0;
+    reader->P();
+    oldLevel = interrupt->SetLevel(IntOff);
+    while ((inLine == 0) && (inEndOfFile == 0) && !inputEnded) {
+	readWaiting = TRUE;
+	lineAvail->P();
+    }
+    if (inLine == 0) {
+	if (inEndOfFile > 0)
+	    inEndOfFile--;
+    } else
+	do {
+	    ch = inBuffer[inHead];
+	    inHead = (inHead + 1) % ConsoleBufferSize;
+	    inCount--;
+	    inLine--;
+	    buffer[count++] = ch;
+	} while ((ch != '\n') && (count < size) && (inLine > 0));
+    (void) interrupt->SetLevel(oldLevel);
+    reader->V();
+    return count;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::ReadAvail
+// 	A character has been typed, or the input has run out.  Apply the
+//	line discipline: erase characters take back the last character
+//	of the line being typed, and a newline or ^D finishes the line,
+//	waking up Read.  When the ring buffer is full, the line is
+//	finished as it is, and anything typed after that is lost.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::ReadAvail()
+{
+    char ch = console->GetChar();
+
+    if (ch == EOF) {
+	DEBUG('C', "Console input ended\n");
+	inputEnded = TRUE;
+	EndLine();
+    } else if ((ch == EraseChar) || (ch == DeleteChar)) {
+	if (inCount > inLine)
+	    inCount--;
+    } else if (ch == EndOfFileChar) {
+	if (inCount == inLine)
+	    inEndOfFile++;
+	EndLine();
+    } else if (inCount < ConsoleBufferSize) {
+	inBuffer[(inHead + inCount) % ConsoleBufferSize] = ch;
+	inCount++;
+	if ((ch == '\n') || (inCount == ConsoleBufferSize))
+	    EndLine();
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::EndLine
+// 	Everything typed so far can now be read; wake up Read, if it
+//	is waiting.  Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::EndLine()
+{
+    inLine = inCount;
+    DEBUG('C', "Console has %d characters to read\n", inLine);
+    if (readWaiting) {
+	readWaiting = FALSE;
+	lineAvail->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::StartOutput
+// 	Give the display as many characters as it will take, from the
+//	front of the ring buffer; they need to be in one piece, so a
+//	burst stops at the end of the buffer.  Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::StartOutput()
+{
+    outBusy = min(outCount, ConsoleBufferSize - outHead);
+    outBusy = min(outBusy, ConsoleBurst);
+    DEBUG('C', "Console putting %d characters\n", outBusy);
+    console->PutChars(&outBuffer[outHead], outBusy);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WaitForOutput
+// 	Sleep until the display finishes its burst.  Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::WaitForOutput()
+{
+    numWaiting++;
+    outputDone->P();
+}
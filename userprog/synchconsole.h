@@ -0,0 +1,83 @@
+// synchconsole.h
+//	Data structures for the kernel's console driver, which the
+//	system calls print through.
+//
+//	Output is buffered: Write copies the characters into a ring
+//	buffer and returns, unless the ring is full.  The driver hands
+//	the display as many characters as it will take at once (see
+//	Console::PutChars), so it takes one interrupt per burst, rather
+//	than one per character; each interrupt starts the next burst.
+//
+//	Input is cooked a line at a time: characters typed go into a
+//	second ring buffer, where backspace can still erase them, and
+//	only a newline (or ^D) hands the line on to Read.  So a program
+//	waiting in Read is woken once per line, not once per character.
+//	Characters are not echoed; a host terminal does that itself.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
+
+#include "copyright.h"
+#include "console.h"
+#include "synch.h"
+
+#define ConsoleBufferSize	1024	// characters waiting for the display,
+					// or for Read
+
+#define EraseChar	'\b'		// erase the last character typed
+#define DeleteChar	'\177'		// same
+#define EndOfFileChar	'\004'		// ^D: end the line, or the input
+
+// The following class defines the console as the kernel sees it.
+
+class SynchConsole {
+  public:
+    SynchConsole(char *readFile, char *writeFile);
+				// Initialize the console device
+    ~SynchConsole();
+
+    void Write(char *buffer, int size);
+				// Queue "size" characters for the display;
+				// wait only if the ring buffer fills up
+    void Flush();		// Wait until everything written is out
+    int Read(char *buffer, int size);
+				// Wait for a line, and return up to "size"
+				// characters of it; 0 at the end of input
+
+    void WriteDone();		// Called by the display interrupt handler
+    void ReadAvail();		// Called by the keyboard interrupt handler
+
+  private:
+    void StartOutput();		// Give the display its next burst
+    void WaitForOutput();	// Sleep until the display finishes a burst
+    void EndLine();		// Hand what has been typed on to Read
+
+    Console *console;		// the raw device
+    Semaphore *writer;		// one Write at a time, so that what each
+				// one writes comes out together
+    Semaphore *outputDone;	// for threads waiting for room, or
+				// for the ring buffer to empty
+    int numWaiting;		// how many of them there are
+    Semaphore *reader;		// one Read at a time
+    Semaphore *lineAvail;	// V'ed when a line is typed, for Read
+    bool readWaiting;		// is Read waiting on it?
+
+    char outBuffer[ConsoleBufferSize];
+    int outHead;		// where the next character to send is
+    int outCount;		// characters in the ring buffer, including
+				// those the display is putting
+    int outBusy;		// characters the display is putting
+
+    char inBuffer[ConsoleBufferSize];
+    int inHead;			// where the next character to read is
+    int inCount;		// characters typed and not yet read
+    int inLine;			// how many of them are in finished lines
+    int inEndOfFile;		// ^Ds typed on an empty line, not yet read
+    bool inputEnded;		// has the keyboard's file run out?
+};
+
+#endif // SYNCHCONSOLE_H
@@ -45,6 +45,8 @@
 
 #define SC_Time		19
 
+#define SC_SetPriority	20
+
 #ifndef IN_ASM
 
 /* The system call interface.  These are the operations the Nachos
@@ -110,7 +112,10 @@ void Create(char *name);
  */
 OpenFileId Open(char *name);
 
-/* Write "size" bytes from "buffer" to the open file. */
+/* Write "size" bytes from "buffer" to the open file.  Only ConsoleOutput
+ * can be written so far; the kernel buffers what is written to it, so
+ * Write returns before the characters reach the display.
+ */
 void Write(char *buffer, int size, OpenFileId id);
 
 /* Read "size" bytes from the open file into "buffer".  
@@ -118,6 +123,8 @@ void Write(char *buffer, int size, OpenFileId id);
  * long enough, or if it is an I/O device, and there aren't enough 
  * characters to read, return whatever is available (for I/O devices, 
  * you should always wait until you can return at least one character).
+ * Only ConsoleInput can be read so far; it is read a line at a time, so
+ * Read waits for a whole line, and returns no more than one.
  */
 int Read(char *buffer, int size, OpenFileId id);
 
@@ -158,6 +165,15 @@ int GetPPID (void);
 void Sleep (unsigned);
 
 int GetTime (void);
+
+/* Set the base priority of the thread "pid" (0 for the caller), from 0,
+ * the highest, to 7.  With the feedback queues, a thread drops below
+ * its base priority as it uses up time slices, and goes back up to it
+ * when it sleeps; with the fair and stride schedulers, each priority
+ * down gets half the share of the CPU.  Returns the old base priority,
+ * or -1 if there is no such thread or priority.
+ */
+int SetPriority (int pid, int priority);
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
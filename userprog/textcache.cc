@@ -0,0 +1,110 @@
+// textcache.cc
+//	Routines to find the frames already holding a program's code.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "textcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TextCache::TextCache
+// 	Initialize an empty text cache.
+//----------------------------------------------------------------------
+
+TextCache::TextCache()
+{
+    for (int i = 0; i < TextBuckets; i++)
+	buckets[i] = NULL;
+    for (int i = 0; i < NumPhysPages; i++)
+	byFrame[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// TextCache::~TextCache
+// 	De-allocate the text cache.  The frames are not ours to free.
+//----------------------------------------------------------------------
+
+TextCache::~TextCache()
+{
+    for (int i = 0; i < NumPhysPages; i++)
+	Remove(i);
+}
+
+//----------------------------------------------------------------------
+// TextCache::Hash
+// 	Return which hash chain page "page" of "program" is on.
+//----------------------------------------------------------------------
+
+int
+TextCache::Hash(char *program, int page)
+{
+    unsigned int hash = page;
+
+    for (char *p = program; *p != '\0'; p++)
+	hash = hash * 31 + (unsigned char) *p;
+    return hash % TextBuckets;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Find
+// 	Return the frame holding page "page" of the program loaded from
+//	the file named "program", or -1 if no frame does.
+//----------------------------------------------------------------------
+
+int
+TextCache::Find(char *program, int page)
+{
+    for (TextPage *p = buckets[Hash(program, page)]; p != NULL; p = p->next)
+	if ((p->page == page) && !strcmp(p->program, program))
+	    return p->frame;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Add
+// 	Record that "frame" holds page "page" of the program loaded from
+//	the file named "program".
+//----------------------------------------------------------------------
+
+void
+TextCache::Add(char *program, int page, int frame)
+{
+    TextPage *p = new TextPage;
+    int bucket = Hash(program, page);
+
+    ASSERT(byFrame[frame] == NULL);
+    p->program = new char[strlen(program) + 1];
+    strcpy(p->program, program);
+    p->page = page;
+    p->frame = frame;
+    p->next = buckets[bucket];
+    buckets[bucket] = p;
+    byFrame[frame] = p;
+    DEBUG('a', "Caching page %d of %s in frame %d\n", page, program, frame);
+}
+
+//----------------------------------------------------------------------
+// TextCache::Remove
+// 	Forget the text in "frame", because no address space is using it
+//	any more.  Does nothing if the frame does not hold cached text.
+//----------------------------------------------------------------------
+
+void
+TextCache::Remove(int frame)
+{
+    TextPage *p = byFrame[frame];
+    TextPage **link;
+
+    if (p == NULL)
+	return;
+    for (link = &buckets[Hash(p->program, p->page)]; *link != p;
+							link = &(*link)->next)
+	;
+    *link = p->next;
+    byFrame[frame] = NULL;
+    delete [] p->program;
+    delete p;
+}
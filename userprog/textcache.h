@@ -0,0 +1,53 @@
+// textcache.h
+//	Data structures for the kernel's cache of program text: the
+//	frames holding code pages loaded from object code files, found
+//	by the file's name and the page number.  Every address space
+//	running the same program maps its code pages to the same frames,
+//	read-only, and a frame leaves the cache when its last user is
+//	gone.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define TextBuckets	64		// hash chains in the cache
+
+// The following class defines one cached page of text.
+
+class TextPage {
+  public:
+    char *program;			// the object code file's name
+    int page;				// the virtual page it is loaded at
+    int frame;				// the frame holding it
+    TextPage *next;			// the rest of the hash chain
+};
+
+// The following class defines the text cache.
+
+class TextCache {
+  public:
+    TextCache();			// Initialize an empty cache
+    ~TextCache();			// De-allocate the cache
+
+    int Find(char *program, int page);	// Return the frame holding "page"
+					// of "program", or -1
+    void Add(char *program, int page, int frame);
+					// "frame" now holds "page" of
+					// "program"
+    void Remove(int frame);		// "frame" no longer holds text, if
+					// it ever did
+
+  private:
+    int Hash(char *program, int page);	// Which chain a page is on
+
+    TextPage *buckets[TextBuckets];	// the hash chains
+    TextPage *byFrame[NumPhysPages];	// the page in each frame, if any
+};
+
+#endif // TEXTCACHE_H
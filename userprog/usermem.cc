@@ -0,0 +1,148 @@
+// usermem.cc
+//	Routines to copy data between the kernel and the running user
+//	program's memory, a page at a time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "usermem.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// UserPage
+// 	Translate "userAddr" in the running program, for reading or
+//	"writing", and return where it is in "mainMemory".  A page fault
+//	or a write to a copy-on-write page is handled here, just as
+//	ExceptionHandler would handle it, and the translation is tried
+//	again.
+//
+//	Returns NULL if the address is not mapped, or is read-only and
+//	we are writing.
+//----------------------------------------------------------------------
+
+static char *
+UserPage(int userAddr, bool writing)
+{
+    AddrSpace *space = currentThread->space;
+    ExceptionType exception;
+    int physAddr;
+
+    for (;;) {
+	exception = machine->Translate(userAddr, &physAddr, 1, writing);
+	if (exception == NoException)
+	    break;
+	if ((exception == PageFaultException) && space->PageFault(userAddr))
+	    continue;
+	if ((exception == ReadOnlyException) && space->CopyOnWrite(userAddr))
+	    continue;
+	DEBUG('a', "Can't %s user address 0x%x\n", 
+		writing ? "write" : "read", userAddr);
+	return NULL;
+    }
+    if (writing)			// the simulator may have decoded
+	machine->InvalidateCodePage(physAddr / PageSize);	// code here
+    return &machine->mainMemory[physAddr];
+}
+
+//----------------------------------------------------------------------
+// CopyIn
+// 	Copy "size" bytes from the running program's memory at
+//	"userAddr" into "buffer", a page at a time.
+//
+//	Returns FALSE if some of it could not be read; "buffer" then
+//	holds whatever came before that.
+//----------------------------------------------------------------------
+
+bool
+CopyIn(int userAddr, char *buffer, int size)
+{
+    char *from;
+    int chunk;
+
+    while (size > 0) {
+	chunk = PageSize - (unsigned) userAddr % PageSize;
+	if (chunk > size)
+	    chunk = size;
+	from = UserPage(userAddr, FALSE);
+	if (from == NULL)
+	    return FALSE;
+	memcpy(buffer, from, chunk);
+	userAddr += chunk;
+	buffer += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyOut
+// 	Copy "size" bytes from "buffer" into the running program's
+//	memory at "userAddr", a page at a time.
+//
+//	Returns FALSE if some of it could not be written; whatever came
+//	before that has been.
+//----------------------------------------------------------------------
+
+bool
+CopyOut(char *buffer, int userAddr, int size)
+{
+    char *to;
+    int chunk;
+
+    while (size > 0) {
+	chunk = PageSize - (unsigned) userAddr % PageSize;
+	if (chunk > size)
+	    chunk = size;
+	to = UserPage(userAddr, TRUE);
+	if (to == NULL)
+	    return FALSE;
+	memcpy(to, buffer, chunk);
+	userAddr += chunk;
+	buffer += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyInString
+// 	Copy a null-terminated string from the running program's memory
+//	at "userAddr" into "buffer", which holds "size" characters, so
+//	the string may be at most "size" - 1 characters long.  "buffer"
+//	is always null-terminated.
+//
+//	Returns the length of the string, not counting the null.  Returns
+//	-1 if the string could not be read, or is too long (there is no
+//	null in its first "size" characters).
+//----------------------------------------------------------------------
+
+int
+CopyInString(int userAddr, char *buffer, int size)
+{
+    char *from, *end;
+    int chunk, length = 0;
+
+    ASSERT(size > 0);
+    while (length < size) {
+	chunk = PageSize - (unsigned) userAddr % PageSize;
+	if (chunk > size - length)
+	    chunk = size - length;
+	from = UserPage(userAddr, FALSE);
+	if (from == NULL)
+	    break;
+	end = (char *) memchr(from, '\0', chunk);
+	if (end != NULL) {
+	    memcpy(&buffer[length], from, end - from);
+	    length += end - from;
+	    buffer[length] = '\0';
+	    return length;
+	}
+	memcpy(&buffer[length], from, chunk);
+	userAddr += chunk;
+	length += chunk;
+    }
+    buffer[(length < size) ? length : size - 1] = '\0';
+    return -1;
+}
@@ -0,0 +1,32 @@
+// usermem.h
+//	Routines for the kernel to copy data in from, and out to, the
+//	memory of the user program that is running.
+//
+//	Each translates the user address once per page, and copies
+//	straight to or from the page's frame in "mainMemory".  Pages that
+//	are not loaded yet, or are shared copy-on-write, are dealt with
+//	the same way as if the program had touched them itself; an
+//	address that is not mapped makes the copy fail.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef USERMEM_H
+#define USERMEM_H
+
+#include "copyright.h"
+
+extern bool CopyIn(int userAddr, char *buffer, int size);
+				// Copy "size" bytes from the program at
+				// "userAddr"; FALSE if it can't be read
+extern bool CopyOut(char *buffer, int userAddr, int size);
+				// Copy "size" bytes to the program at
+				// "userAddr"; FALSE if it can't be written
+extern int CopyInString(int userAddr, char *buffer, int size);
+				// Copy a null-terminated string from the
+				// program, at most "size" - 1 characters;
+				// return its length, or -1 if it can't be
+				// read or is longer
+
+#endif // USERMEM_H
@@ -0,0 +1,218 @@
+// frametable.cc
+//	Routines to keep track of the physical frames, and to choose
+//	one to take away when memory is full.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ClockPolicy::Victim
+// 	Sweep the frames, starting at the clock hand, for one whose page
+//	has not been used since the hand last passed; clear the use bits
+//	of each one passed over, giving it a second chance.  Two sweeps
+//	are enough to find one, if any frame can be taken at all.
+//----------------------------------------------------------------------
+
+int
+ClockPolicy::Victim(FrameTable *frames)
+{
+    int frame;
+
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+	frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+	if (frames->IsMapped(frame) && !frames->ClearUse(frame))
+	    return frame;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::FIFOPolicy
+// 	Initialize a FIFO policy; no frames have been loaded yet.
+//----------------------------------------------------------------------
+
+FIFOPolicy::FIFOPolicy()
+{
+    loads = 0;
+    for (int i = 0; i < NumPhysPages; i++)
+	loadedAt[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::Loaded
+// 	Remember when "frame" was given its page.
+//----------------------------------------------------------------------
+
+void
+FIFOPolicy::Loaded(int frame)
+{
+    loadedAt[frame] = loads++;
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::Victim
+// 	Return the frame that can be taken whose page was loaded first.
+//----------------------------------------------------------------------
+
+int
+FIFOPolicy::Victim(FrameTable *frames)
+{
+    int victim = -1;
+
+    for (int frame = 0; frame < NumPhysPages; frame++)
+	if (frames->IsMapped(frame) && ((victim == -1) ||
+			((int) (loadedAt[frame] - loadedAt[victim]) < 0)))
+	    victim = frame;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table.  Which frames are free is kept by
+//	"frameMap"; here, no page is mapped to any of them yet.
+//
+//	"how" -- the policy for choosing a frame to take; the table
+//		de-allocates it when done
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable(ReplacementPolicy *how)
+{
+    policy = how;
+    for (int i = 0; i < NumPhysPages; i++) {
+	users[i] = NULL;
+	taking[i] = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::~FrameTable
+// 	De-allocate the frame table.
+//----------------------------------------------------------------------
+
+FrameTable::~FrameTable()
+{
+    FrameUser *user;
+
+    for (int i = 0; i < NumPhysPages; i++)
+	while (users[i] != NULL) {
+	    user = users[i];
+	    users[i] = user->next;
+	    delete user;
+	}
+    delete policy;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Allocate
+// 	Return a frame for a page to be loaded into.  If none is free,
+//	ask the policy for one, and have every address space using it
+//	send its page out.
+//
+//	Sending a page out to swap may wait for the disk, and meanwhile
+//	the frame's other pages are still mapped; it is marked so that no
+//	one else takes it too.  No page is mapped to the frame returned,
+//	so it will not be taken while it is being filled; the caller
+//	calls AddUser once it is.
+//----------------------------------------------------------------------
+
+int
+FrameTable::Allocate()
+{
+    int frame = frameMap->Find();
+
+    if (frame != -1)
+	return frame;
+    frame = policy->Victim(this);
+    ASSERT(frame != -1);		// every frame is being filled
+    machine->FlushSoftTLB();		// the policy may have cleared use bits
+    DEBUG('a', "Taking frame %d\n", frame);
+    taking[frame] = TRUE;
+    while (users[frame] != NULL)	// each PageOut removes its user
+	users[frame]->space->PageOut(users[frame]->virtualPage);
+    taking[frame] = FALSE;
+    stats->numPageOuts++;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AddUser
+// 	Record that page "vpn" of "space", translated by "pageEntry", is
+//	in "frame", and so the frame can be taken from it.  The policy
+//	is told when the first page goes into a frame.
+//----------------------------------------------------------------------
+
+void
+FrameTable::AddUser(int frame, AddrSpace *space, unsigned int vpn,
+		    TranslationEntry *pageEntry)
+{
+    FrameUser *user = new FrameUser;
+
+    if (users[frame] == NULL)
+	policy->Loaded(frame);
+    user->space = space;
+    user->virtualPage = vpn;
+    user->entry = pageEntry;
+    user->next = users[frame];
+    users[frame] = user;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::RemoveUser
+// 	Record that the page of "space" in "frame" is no longer there.
+//	An address space maps a frame from at most one page.  Once just
+//	one address space is left, the frame is its own.
+//----------------------------------------------------------------------
+
+void
+FrameTable::RemoveUser(int frame, AddrSpace *space)
+{
+    FrameUser **link, *user;
+
+    for (link = &users[frame]; *link != NULL; link = &(*link)->next)
+	if ((*link)->space == space) {
+	    user = *link;
+	    *link = user->next;
+	    delete user;
+	    return;
+	}
+    ASSERT(FALSE);			// it was never there
+}
+
+//----------------------------------------------------------------------
+// FrameTable::ClearUse
+// 	Return TRUE if any page in "frame" has been used since the last
+//	call, and clear their use bits.  A page in a TLB has its use bit
+//	set there, not in the page table, so the TLBs of every CPU are
+//	checked (and cleared) too.  The caller must flush the machine's
+//	soft TLB, so that the next use is noticed.
+//----------------------------------------------------------------------
+
+bool
+FrameTable::ClearUse(int frame)
+{
+    bool used = machine->ClearFrameUse(frame);
+
+    for (FrameUser *user = users[frame]; user != NULL; user = user->next) {
+	used = used || user->entry->use;
+	user->entry->use = FALSE;
+    }
+    return used;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	Give back a frame that no address space is using any more.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Free(int frame)
+{
+    ASSERT(users[frame] == NULL);
+    frameMap->Clear(frame);
+}
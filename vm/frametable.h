@@ -0,0 +1,110 @@
+// frametable.h
+//	Data structures to keep track of what is in each physical frame,
+//	for virtual memory: which pages of which address spaces, so that
+//	once memory is full, a frame can be taken away from its pages
+//	(sending them out to swap) and given to another.
+//
+//	A frame may be mapped by more than one address space: shared
+//	copy-on-write after a Fork, or holding code that every address
+//	space running the program shares.  Taking the frame takes it
+//	from all of them.  Which frame is taken is up to a
+//	ReplacementPolicy; frames no page is mapped to yet (those being
+//	filled) are never taken.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+class FrameTable;
+
+// The following class defines how to choose the frame to take away
+// when memory is full.  Each kind of policy is a subclass.
+
+class ReplacementPolicy {
+  public:
+    virtual ~ReplacementPolicy() {}
+
+    virtual void Loaded(int frame) {}	// "frame" has just been given
+					// a page
+    virtual int Victim(FrameTable *frames) = 0;
+					// Return a frame that is mapped,
+					// or -1 if there are none
+};
+
+// Second chance: a "clock hand" sweeps the frames in turn, taking the
+// first whose page has not been used since the hand last passed it,
+// and clearing the use bits of the others as it goes.
+
+class ClockPolicy : public ReplacementPolicy {
+  public:
+    ClockPolicy() { hand = 0; }
+    int Victim(FrameTable *frames);
+
+  private:
+    int hand;			// the next frame to look at
+};
+
+// First in, first out: take the frame that was given its page the
+// longest time ago, used or not.
+
+class FIFOPolicy : public ReplacementPolicy {
+  public:
+    FIFOPolicy();
+    void Loaded(int frame);
+    int Victim(FrameTable *frames);
+
+  private:
+    unsigned int loadedAt[NumPhysPages];	// when each frame got its page
+    unsigned int loads;			// pages loaded so far
+};
+
+// The following class defines one page mapped to a frame.
+
+class FrameUser {
+  public:
+    AddrSpace *space;			// the address space, and
+    unsigned int virtualPage;		// its page mapped to the frame
+    TranslationEntry *entry;		// the page's translation
+    FrameUser *next;			// the frame's other users
+};
+
+// The following class defines the frame table.
+
+class FrameTable {
+  public:
+    FrameTable(ReplacementPolicy *how);	// Initialize; every frame is free
+    ~FrameTable();			// De-allocate, and the policy too
+
+    int Allocate();			// Return a free frame, not mapped,
+					// first evicting a frame's pages if
+					// memory is full
+    void AddUser(int frame, AddrSpace *space, unsigned int vpn,
+		 TranslationEntry *pageEntry);
+					// Page "vpn" of "space", translated
+					// by "pageEntry", is now in "frame"
+    void RemoveUser(int frame, AddrSpace *space);
+					// The page of "space" in "frame" is
+					// no longer there
+    void Free(int frame);		// Give back a frame no one is using
+
+    bool IsMapped(int frame)
+	{ return (users[frame] != NULL) && !taking[frame]; }
+					// May "frame" be taken?
+    bool ClearUse(int frame);		// Has any page in "frame" been used
+					// since the last call?
+
+  private:
+    ReplacementPolicy *policy;		// chooses which frame to take
+    FrameUser *users[NumPhysPages];	// the pages mapped to each frame
+    bool taking[NumPhysPages];		// is the frame being taken, its
+					// pages sent out one at a time?
+};
+
+#endif // FRAMETABLE_H
@@ -0,0 +1,150 @@
+// ipt.cc
+//	Routines to manage the inverted page table.  See ipt.h for how
+//	it is organized.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "ipt.h"
+
+//----------------------------------------------------------------------
+// InvertedPageTable::InvertedPageTable
+// 	Initialize an empty table.
+//----------------------------------------------------------------------
+
+InvertedPageTable::InvertedPageTable()
+{
+    for (int i = 0; i < NumPhysPages; i++) {
+	frames[i].space = NULL;
+	buckets[i] = NULL;
+    }
+    freeEntries = NULL;
+    numEntries = 0;
+}
+
+//----------------------------------------------------------------------
+// InvertedPageTable::~InvertedPageTable
+// 	De-allocate the entries for shared frames.
+//----------------------------------------------------------------------
+
+InvertedPageTable::~InvertedPageTable()
+{
+    IPTEntry *entry;
+
+    for (int i = 0; i < NumPhysPages; i++)
+	while (buckets[i] != NULL) {
+	    entry = buckets[i];
+	    buckets[i] = entry->next;
+	    if ((entry < frames) || (entry >= frames + NumPhysPages))
+		delete entry;
+	}
+    while (freeEntries != NULL) {
+	entry = freeEntries;
+	freeEntries = entry->next;
+	delete entry;
+    }
+}
+
+//----------------------------------------------------------------------
+// InvertedPageTable::Hash
+// 	Return the hash chain for page "vpn" of "space".  Address spaces
+//	are spread out by their addresses; pages of the same space are
+//	spread out by their numbers.
+//----------------------------------------------------------------------
+
+int
+InvertedPageTable::Hash(AddrSpace *space, unsigned int vpn)
+{
+    unsigned long key = ((unsigned long) space >> 4) * 0x9e3779b1 + vpn;
+
+    return (int) (key % NumPhysPages);
+}
+
+//----------------------------------------------------------------------
+// InvertedPageTable::Insert
+// 	Record that page "vpn" of "space" is in physical page "frame",
+//	and return its translation: valid, unused and clean, and
+//	read-only if "readOnly" is set.  The kernel may change the
+//	translation, until the page is removed.
+//
+//	The page must not be in the table already.  If the frame's own
+//	entry is in use (for another address space sharing the frame),
+//	an entry from the pool is used instead.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+InvertedPageTable::Insert(AddrSpace *space, unsigned int vpn, int frame,
+			  bool readOnly)
+{
+    int bucket = Hash(space, vpn);
+    IPTEntry *entry = &frames[frame];
+
+    ASSERT(Lookup(space, vpn) == NULL);
+    if (entry->space != NULL) {
+	entry = freeEntries;
+	if (entry != NULL)
+	    freeEntries = entry->next;
+	else
+	    entry = new IPTEntry;
+    }
+    entry->space = space;
+    entry->translation.virtualPage = vpn;
+    entry->translation.physicalPage = frame;
+    entry->translation.valid = TRUE;
+    entry->translation.readOnly = readOnly;
+    entry->translation.use = FALSE;
+    entry->translation.dirty = FALSE;
+    entry->next = buckets[bucket];
+    buckets[bucket] = entry;
+    numEntries++;
+    return &entry->translation;
+}
+
+//----------------------------------------------------------------------
+// InvertedPageTable::Remove
+// 	Forget the translation for page "vpn" of "space", which is no
+//	longer in memory.  Nothing happens if it is not in the table.
+//----------------------------------------------------------------------
+
+void
+InvertedPageTable::Remove(AddrSpace *space, unsigned int vpn)
+{
+    IPTEntry **link, *entry;
+
+    for (link = &buckets[Hash(space, vpn)]; *link != NULL;
+						link = &(*link)->next) {
+	entry = *link;
+	if ((entry->space == space) &&
+			(entry->translation.virtualPage == (int) vpn)) {
+	    *link = entry->next;
+	    entry->space = NULL;
+	    if ((entry < frames) || (entry >= frames + NumPhysPages)) {
+		entry->next = freeEntries;
+		freeEntries = entry;
+	    }
+	    numEntries--;
+	    return;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// InvertedPageTable::Lookup
+// 	Return the translation for page "vpn" of "space", or NULL if the
+//	page is not in memory.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+InvertedPageTable::Lookup(AddrSpace *space, unsigned int vpn)
+{
+    IPTEntry *entry;
+
+    for (entry = buckets[Hash(space, vpn)]; entry != NULL;
+						entry = entry->next)
+	if ((entry->space == space) &&
+			(entry->translation.virtualPage == (int) vpn))
+	    return &entry->translation;
+    return NULL;
+}
@@ -0,0 +1,79 @@
+// ipt.h
+//	Data structures for the inverted page table: one table for the
+//	whole machine, holding the translation of every page that is in
+//	memory, found by hashing its address space and virtual page
+//	number.  The kernel refills the TLB from it after a miss.
+//
+//	This is the only place the translations of pages in memory are
+//	kept.  An address space's own page table holds just what the
+//	kernel knows about each page (whether it is mapped, whether it is
+//	code, where it is in swap), which the machine never sees.
+//
+//	The table has an entry for each physical frame, and one hash
+//	chain per frame, so its size depends on the size of memory rather
+//	than on the number or size of the address spaces.  A frame shared
+//	by several address spaces (after Fork, or holding code) needs an
+//	entry for each extra one; those come from a pool.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef IPT_H
+#define IPT_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+
+// How the kernel chooses which TLB entry to replace on a miss, when
+// every entry is in use.
+
+enum TLBReplacement { RandomTLB,	// any entry, at random
+		      LRUTLB		// the least recently used one
+};
+
+// The following class defines one translation in the table.
+
+class IPTEntry {
+  public:
+    AddrSpace *space;			// the address space whose page
+					// this is, or NULL if not in use
+    TranslationEntry translation;	// the page's translation
+    IPTEntry *next;			// the rest of the hash chain
+};
+
+// The following class defines the inverted page table.
+
+class InvertedPageTable {
+  public:
+    InvertedPageTable();		// Initialize an empty table
+    ~InvertedPageTable();		// De-allocate the table
+
+    TranslationEntry *Insert(AddrSpace *space, unsigned int vpn,
+			     int frame, bool readOnly);
+					// Page "vpn" of "space" is now in
+					// "frame"; return its translation
+    void Remove(AddrSpace *space, unsigned int vpn);
+					// Page "vpn" of "space" is no longer
+					// in memory
+    TranslationEntry *Lookup(AddrSpace *space, unsigned int vpn);
+					// Return the translation for page
+					// "vpn" of "space", or NULL if it is
+					// not in memory
+    int NumEntries() { return numEntries; }
+
+  private:
+    int Hash(AddrSpace *space, unsigned int vpn);
+					// Which chain a page is on
+
+    IPTEntry frames[NumPhysPages];	// the entry for the page in each
+					// frame
+    IPTEntry *buckets[NumPhysPages];	// the hash chains
+    IPTEntry *freeEntries;		// entries for shared frames, no
+					// longer in use
+    int numEntries;			// translations in the table
+};
+
+#endif // IPT_H
@@ -0,0 +1,79 @@
+// swap.cc
+//	Routines to read and write pages in the swap space.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "swap.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SwapSpace::SwapSpace
+// 	Create the swap file, big enough for "numSlots" pages, and open
+//	it.  Any old swap file is thrown away.
+//----------------------------------------------------------------------
+
+SwapSpace::SwapSpace(char *name, int numSlots)
+{
+    bool created;
+
+    fileName = name;
+    fileSystem->Remove(fileName);
+    created = fileSystem->Create(fileName, numSlots * PageSize);
+    ASSERT(created);			// else no room for swap
+    file = fileSystem->Open(fileName);
+    ASSERT(file != NULL);
+    slots = new BitMap(numSlots);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::~SwapSpace
+// 	Close and remove the swap file.
+//----------------------------------------------------------------------
+
+SwapSpace::~SwapSpace()
+{
+    delete slots;
+    delete file;
+    fileSystem->Remove(fileName);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Allocate, SwapSpace::Free
+// 	Find a free slot and mark it in use, or give one back.
+//----------------------------------------------------------------------
+
+int
+SwapSpace::Allocate()
+{
+    return slots->Find();
+}
+
+void
+SwapSpace::Free(int slot)
+{
+    slots->Clear(slot);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadPage, SwapSpace::WritePage
+// 	Copy a page between memory and a slot of the swap file.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadPage(int slot, char *into)
+{
+    ASSERT(slots->Test(slot));
+    file->ReadAt(into, PageSize, slot * PageSize);
+    stats->numSwapReads++;
+}
+
+void
+SwapSpace::WritePage(int slot, char *from)
+{
+    ASSERT(slots->Test(slot));
+    file->WriteAt(from, PageSize, slot * PageSize);
+    stats->numSwapWrites++;
+}
@@ -0,0 +1,43 @@
+// swap.h
+//	Data structures for the swap space: a file holding the pages
+//	that have been sent out of memory to make room for others, one
+//	page to a slot.  The file is on the Nachos disk, or with the
+//	stub file system, a host file.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "copyright.h"
+#include "openfile.h"
+#include "bitmap.h"
+
+#define SwapFileName	"SWAP"		// where the swap space is kept
+#define NumSwapPages	1024		// how many pages it holds
+
+// The following class defines the swap space.
+
+class SwapSpace {
+  public:
+    SwapSpace(char *name, int numSlots);
+					// Create the swap file, with every
+					// slot free
+    ~SwapSpace();			// Remove the swap file
+
+    int Allocate();			// Return a free slot; -1 if full
+    void Free(int slot);		// Give a slot back
+    void ReadPage(int slot, char *into);
+					// Copy a page in from "slot"
+    void WritePage(int slot, char *from);
+					// Copy a page out to "slot"
+
+  private:
+    char *fileName;			// the swap file's name
+    OpenFile *file;			// the swap file, open
+    BitMap *slots;			// which slots are in use
+};
+
+#endif // SWAP_H